@@ -0,0 +1,730 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+// micro and macro benchmarks of TTFRRW
+// usage : ttfrrw_bench [-n iterations] [-batch fonts count] [-info_logs] [-o results.json] [font files...]
+// the fonts are testfont.ttf and testfont2_colr.ttf of the project if not given
+// the batch corpus is made of the fonts, repeated until the fonts count (300 by default)
+// -info_logs run only the info_logs entries, the cmap and glyf parsers timed in this build :
+// - ttfrrw_bench is built like the ttfrrw library, so without the info logs by default (info_logs/off)
+// - ttfrrw_bench_info_logs is built with its own library compiled with TTFRRW_INFO_LOGS (info_logs/on)
+// the target ttfrrw_bench_info_logs_compare run the two, one after the other
+
+#include "ttfrrw.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef PROJECT_PATH
+#define PROJECT_PATH "."
+#endif
+
+///////////////////////////////////////////////////////////////////////
+//// ALLOCATIONS COUNT ////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// the replaced operators use malloc and free, gcc see a mismatch when they are inlined
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// all the allocations of the process, the hooked ones and the stl ones
+static std::atomic<uint64_t> s_AllocationsCount(0U);
+
+void* operator new(std::size_t count)
+{
+	s_AllocationsCount.fetch_add(1U, std::memory_order_relaxed);
+	void* ptr = malloc(count ? count : 1U);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+void* operator new[](std::size_t count)
+{
+	s_AllocationsCount.fetch_add(1U, std::memory_order_relaxed);
+	void* ptr = malloc(count ? count : 1U);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+///////////////////////////////////////////////////////////////////////
+//// BENCH ////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+struct BenchResult
+{
+	std::string name;
+	size_t iterations = 0U;
+	double minSeconds = 0.0;
+	double medianSeconds = 0.0;
+	double bytesPerIteration = 0.0; // for the MB/s, 0 if not relevant
+	double itemsPerIteration = 0.0; // for the items/s, 0 if not relevant
+	std::string itemsUnit; // glyphs, lookups...
+	double allocationsPerIteration = 0.0;
+};
+
+static std::vector<BenchResult> s_Results;
+
+// vFunc is called once for warm up, then vIterations times
+// vFunc return the time in seconds of the part measured
+// the throughputs are computed on the median time
+template<typename F>
+static void RunMeasured(const std::string& vName, const size_t& vIterations,
+	const double& vBytes, const double& vItems, const char* vItemsUnit, F vFunc)
+{
+	vFunc();
+
+	std::vector<double> times;
+	times.reserve(vIterations);
+	const uint64_t allocationsStart = s_AllocationsCount.load();
+	for (size_t idx = 0; idx < vIterations; idx++)
+	{
+		times.push_back(vFunc());
+	}
+	const uint64_t allocationsEnd = s_AllocationsCount.load();
+	std::sort(times.begin(), times.end());
+
+	BenchResult res;
+	res.name = vName;
+	res.iterations = vIterations;
+	res.minSeconds = times.empty() ? 0.0 : times.front();
+	res.medianSeconds = times.empty() ? 0.0 : times[times.size() / 2U];
+	res.bytesPerIteration = vBytes;
+	res.itemsPerIteration = vItems;
+	res.itemsUnit = vItemsUnit;
+	res.allocationsPerIteration = vIterations ? (double)(allocationsEnd - allocationsStart) / (double)vIterations : 0.0;
+	s_Results.push_back(res);
+
+	printf("%-64s median %12.3f us", res.name.c_str(), res.medianSeconds * 1e6);
+	if (res.bytesPerIteration > 0.0 && res.medianSeconds > 0.0)
+		printf(" | %10.1f MB/s", res.bytesPerIteration / res.medianSeconds / (1024.0 * 1024.0));
+	if (res.itemsPerIteration > 0.0 && res.medianSeconds > 0.0)
+		printf(" | %12.0f %s/s", res.itemsPerIteration / res.medianSeconds, res.itemsUnit.c_str());
+	printf(" | %8.1f allocs\n", res.allocationsPerIteration);
+}
+
+// vFunc is measured as a whole
+template<typename F>
+static void Run(const std::string& vName, const size_t& vIterations,
+	const double& vBytes, const double& vItems, const char* vItemsUnit, F vFunc)
+{
+	RunMeasured(vName, vIterations, vBytes, vItems, vItemsUnit, [&]()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		vFunc();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	});
+}
+
+static size_t GetFileSize(const std::string& vFilePathName)
+{
+	size_t res = 0U;
+	FILE* file = fopen(vFilePathName.c_str(), "rb");
+	if (file)
+	{
+		if (fseek(file, 0, SEEK_END) == 0)
+		{
+			const long size = ftell(file);
+			if (size > 0)
+				res = (size_t)size;
+		}
+		fclose(file);
+	}
+	return res;
+}
+
+static bool ReadFile(const std::string& vFilePathName, std::vector<uint8_t>* vOutDatas)
+{
+	vOutDatas->resize(GetFileSize(vFilePathName));
+	FILE* file = fopen(vFilePathName.c_str(), "rb");
+	const bool res = file && !vOutDatas->empty() && fread(vOutDatas->data(), 1U, vOutDatas->size(), file) == vOutDatas->size();
+	if (file)
+		fclose(file);
+	return res;
+}
+
+static std::string GetFileName(const std::string& vFilePathName)
+{
+	const size_t pos = vFilePathName.find_last_of("/\\");
+	if (pos != std::string::npos)
+		return vFilePathName.substr(pos + 1U);
+	return vFilePathName;
+}
+
+// the result of a computation is kept, else the compiler can remove it
+static volatile uint64_t s_Sink = 0U;
+
+///////////////////////////////////////////////////////////////////////
+//// MICRO ////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+static void BenchMemoryStream(const size_t& vIterations)
+{
+	const size_t size = 1024U * 1024U;
+	std::vector<uint8_t> datas(size);
+	for (size_t idx = 0; idx < size; idx++)
+	{
+		datas[idx] = (uint8_t)(idx * 2654435761U >> 24);
+	}
+
+	TTFRRW::MemoryStream mem;
+	mem.BorrowDatas(datas.data(), datas.size());
+
+	Run("MemoryStream/ReadByte", vIterations, (double)size, 0.0, "", [&]()
+	{
+		mem.SetPos(0U);
+		uint64_t sum = 0U;
+		for (size_t idx = 0; idx < size; idx++)
+			sum += mem.ReadByte();
+		s_Sink = sum;
+	});
+
+	Run("MemoryStream/ReadUShort", vIterations, (double)size, 0.0, "", [&]()
+	{
+		mem.SetPos(0U);
+		uint64_t sum = 0U;
+		for (size_t idx = 0; idx < size / 2U; idx++)
+			sum += (uint64_t)mem.ReadUShort();
+		s_Sink = sum;
+	});
+
+	Run("MemoryStream/ReadULong", vIterations, (double)size, 0.0, "", [&]()
+	{
+		mem.SetPos(0U);
+		uint64_t sum = 0U;
+		for (size_t idx = 0; idx < size / 4U; idx++)
+			sum += mem.ReadULong();
+		s_Sink = sum;
+	});
+
+	std::vector<uint16_t> ushorts(size / 2U);
+	Run("MemoryStream/ReadUShortArray", vIterations, (double)size, 0.0, "", [&]()
+	{
+		mem.SetPos(0U);
+		mem.ReadUShortArray(ushorts.data(), ushorts.size());
+		s_Sink = ushorts.back();
+	});
+
+	std::vector<uint32_t> ulongs(size / 4U);
+	Run("MemoryStream/ReadULongArray", vIterations, (double)size, 0.0, "", [&]()
+	{
+		mem.SetPos(0U);
+		mem.ReadULongArray(ulongs.data(), ulongs.size());
+		s_Sink = ulongs.back();
+	});
+
+	Run("MemoryStream/WriteUShort", vIterations, (double)size, 0.0, "", [&]()
+	{
+		TTFRRW::MemoryStream out;
+		for (size_t idx = 0; idx < size / 2U; idx++)
+			out.WriteUShort((int32_t)idx);
+		s_Sink = out.GetSize();
+	});
+
+	Run("MemoryStream/WriteULong", vIterations, (double)size, 0.0, "", [&]()
+	{
+		TTFRRW::MemoryStream out;
+		for (size_t idx = 0; idx < size / 4U; idx++)
+			out.WriteULong((int64_t)idx);
+		s_Sink = out.GetSize();
+	});
+
+	Run("MemoryStream/WriteBytes", vIterations, (double)size, 0.0, "", [&]()
+	{
+		TTFRRW::MemoryStream out;
+		out.WriteBytes(datas.data(), datas.size());
+		s_Sink = out.GetSize();
+	});
+}
+
+static void BenchCMAP(const std::string& vFontFilePathName, const size_t& vIterations)
+{
+	TTFRRW::TTFRRW ttfrrw;
+	if (!ttfrrw.OpenFontFile(vFontFilePathName, TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS))
+		return;
+
+	const std::string prefix = "cmap/" + GetFileName(vFontFilePathName) + "/";
+	const size_t glyphCount = (size_t)ttfrrw.GetFontInfos().m_GlyphCount;
+
+	Run(prefix + "GetGlyphIndexFromCodePoint/bmp", vIterations, 0.0, 65536.0, "lookups", [&]()
+	{
+		uint64_t sum = 0U;
+		for (TTFRRW::CodePoint codePoint = 0U; codePoint < 0x10000U; codePoint++)
+			sum += ttfrrw.GetGlyphIndexFromCodePoint(codePoint);
+		s_Sink = sum;
+	});
+
+	Run(prefix + "GetGlyphIndexFromCodePoint/unicode", vIterations, 0.0, (double)(TTFRRW::MAX_CODEPOINT + 1U), "lookups", [&]()
+	{
+		uint64_t sum = 0U;
+		for (TTFRRW::CodePoint codePoint = 0U; codePoint <= TTFRRW::MAX_CODEPOINT; codePoint++)
+			sum += ttfrrw.GetGlyphIndexFromCodePoint(codePoint);
+		s_Sink = sum;
+	});
+
+	Run(prefix + "GetGlyphIndexFromCodePoint/variation", vIterations, 0.0, 65536.0, "lookups", [&]()
+	{
+		uint64_t sum = 0U;
+		for (TTFRRW::CodePoint codePoint = 0U; codePoint < 0x10000U; codePoint++)
+			sum += ttfrrw.GetGlyphIndexFromCodePoint(codePoint, 0xFE0FU);
+		s_Sink = sum;
+	});
+
+	Run(prefix + "GetCodePointsFromGlyphIndex", vIterations, 0.0, (double)glyphCount, "lookups", [&]()
+	{
+		uint64_t sum = 0U;
+		for (size_t glyphIndex = 0U; glyphIndex < glyphCount; glyphIndex++)
+			sum += ttfrrw.GetCodePointsFromGlyphIndex((TTFRRW::GlyphIndex)glyphIndex).size();
+		s_Sink = sum;
+	});
+}
+
+// the parsers are private, the friend ParserBench call them one by one on a font already opened
+// so each table is parsed again with its dependencies in place, on one thread
+// the parsers who append to the font (cpal, colr) start from an empty state, not measured
+namespace TTFRRW
+{
+	struct ParserBench
+	{
+		struct Parser
+		{
+			const char* tag;
+			const char* name;
+			TTFRRW::ParseFunc func;
+		};
+
+		static void BenchParsers(const std::string& vFontFilePathName, const size_t& vIterations)
+		{
+			std::vector<uint8_t> file;
+			TTFRRW font;
+			font.SetThreadCount(1U);
+			if (!ReadFile(vFontFilePathName, &file) || 
+				!font.OpenFontStream(file.data(), file.size(), TTFRRW_PROCESSING_FLAG_NO_ERRORS))
+				return;
+
+			MemoryStream mem;
+			mem.BorrowDatas(file.data(), file.size());
+
+			const std::string prefix = "parse/" + GetFileName(vFontFilePathName) + "/";
+			const size_t glyphCount = (size_t)font.m_TTFInfos.m_GlyphCount;
+
+			// in the order of the dependencies
+			const Parser parsers[] =
+			{
+				{ "head", "Parse_HEAD_Table", &TTFRRW::Parse_HEAD_Table },
+				{ "maxp", "Parse_MAXP_Table", &TTFRRW::Parse_MAXP_Table },
+				{ "hhea", "Parse_HHEA_Table", &TTFRRW::Parse_HHEA_Table },
+				{ "cmap", "Parse_CMAP_Table", &TTFRRW::Parse_CMAP_Table },
+				{ "name", "Parse_NAME_Table", &TTFRRW::Parse_NAME_Table },
+				{ "post", "Parse_POST_Table", &TTFRRW::Parse_POST_Table },
+				{ "loca", "Parse_LOCA_Table", &TTFRRW::Parse_LOCA_Table },
+				{ "glyf", "Parse_GLYF_Table", &TTFRRW::Parse_GLYF_Table },
+				{ "hmtx", "Parse_HMTX_Table", &TTFRRW::Parse_HMTX_Table },
+				{ "CPAL", "Parse_CPAL_Table", &TTFRRW::Parse_CPAL_Table },
+				{ "COLR", "Parse_COLR_Table", &TTFRRW::Parse_COLR_Table },
+			};
+			for (const auto& parser : parsers)
+			{
+				const auto it = font.m_Tables.find(parser.tag);
+				if (it == font.m_Tables.end())
+					continue;
+
+				const bool isGlyf = (strcmp(parser.tag, "glyf") == 0);
+				RunMeasured(prefix + parser.name, vIterations, (double)it->second.length,
+					isGlyf ? (double)glyphCount : 0.0, isGlyf ? "glyphs" : "", [&]()
+				{
+					if (!strcmp(parser.tag, "CPAL"))
+					{
+						font.m_Palettes.clear();
+					}
+					else if (!strcmp(parser.tag, "COLR"))
+					{
+						for (auto& glyph : font.m_Glyphs)
+						{
+							glyph.m_Color.clear();
+							glyph.m_PaletteIndex.clear();
+							glyph.m_IsLayer = false;
+							glyph.m_Layers.clear();
+							glyph.m_Parents.clear();
+						}
+					}
+
+					const auto start = std::chrono::steady_clock::now();
+					s_Sink = (font.*parser.func)(&mem, TTFRRW_PROCESSING_FLAG_NO_ERRORS, nullptr, nullptr, nullptr);
+					return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				});
+			}
+
+			BenchSimpleGlyf(&font, &mem, prefix, vIterations);
+		}
+
+		// the points of all the simple glyphs, decoded in one store like a range of Parse_GLYF_Table
+		static void BenchSimpleGlyf(TTFRRW* vFont, MemoryStream* vMem, const std::string& vPrefix, const size_t& vIterations)
+		{
+			const auto it = vFont->m_Tables.find("glyf");
+			if (it == vFont->m_Tables.end())
+				return;
+
+			struct SimpleGlyph
+			{
+				GlyphIndex glyphIndex = 0;
+				size_t offset = 0U;
+				int16_t contoursCount = 0;
+			};
+			std::vector<SimpleGlyph> glyphs;
+			double bytes = 0.0;
+			const auto& offsets = *vFont->m_GlyphsOffsets;
+			for (size_t glyphID = 0; glyphID < offsets.size(); glyphID++)
+			{
+				SimpleGlyph glyph;
+				glyph.glyphIndex = (GlyphIndex)glyphID;
+				glyph.offset = it->second.offset + offsets[glyphID];
+				vMem->SetPos(glyph.offset);
+				glyph.contoursCount = (int16_t)vMem->ReadShort();
+				if (glyph.contoursCount <= 0)
+					continue; // composite or empty
+				if (glyphID + 1U < offsets.size() && offsets[glyphID + 1U] > offsets[glyphID])
+					bytes += (double)(offsets[glyphID + 1U] - offsets[glyphID]);
+				glyphs.push_back(glyph);
+			}
+			if (glyphs.empty())
+				return;
+
+			// the store grow at the warm up, then it is reused
+			OutlineStore outlines;
+			Glyph result;
+			Run(vPrefix + "Parse_Simple_Glyf", vIterations, bytes, (double)glyphs.size(), "glyphs", [&]()
+			{
+				OutlineCursor cursor;
+				for (const auto& glyph : glyphs)
+				{
+					vMem->SetPos(glyph.offset + 10U); // after the count of contours and the bbox
+					vFont->Parse_Simple_Glyf(vMem, glyph.glyphIndex, glyph.contoursCount, &outlines, &cursor, &result,
+						nullptr, TTFRRW_PROCESSING_FLAG_NO_ERRORS, nullptr, nullptr, nullptr);
+				}
+				s_Sink = cursor.point;
+			});
+		}
+	};
+}
+
+// the same parsers timed by the profiler on full opens, for the percentiles and the nested timings
+static void BenchTables(const std::string& vFontFilePathName, const size_t& vIterations, TTFRRW::TimingRegistry* vOutTimings)
+{
+	const size_t fontNode = vOutTimings->GetNode(TTFRRW::TimingRegistry::ROOT_NODE, GetFileName(vFontFilePathName).c_str());
+
+	TTFRRW::TTFRRW ttfrrw;
+	for (size_t idx = 0; idx < vIterations; idx++)
+	{
+		if (!ttfrrw.OpenFontFile(vFontFilePathName, TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS))
+			return;
+		vOutTimings->Merge(ttfrrw.GetProfiler()->timings, fontNode);
+	}
+}
+
+// cost of the info logs in the cmap and glyf parsers, where they are in the loops
+// the infos are filtered at runtime (TTFRRW_PROCESSING_FLAG_VERBOSE_ONLY_ERRORS) so the console is not measured,
+// what is left is the cost of the calls, present only if the library is built with TTFRRW_INFO_LOGS
+// the parsers are timed by the profiler, on one thread
+static void BenchInfoLogs(const std::string& vFontFilePathName, const size_t& vIterations)
+{
+#ifdef TTFRRW_INFO_LOGS
+	const char* build = "on";
+#else
+	const char* build = "off";
+#endif
+	const TTFRRW::ttfrrwProcessingFlags flags =
+		TTFRRW::TTFRRW_PROCESSING_FLAG_VERBOSE_ONLY_ERRORS | TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS;
+
+	TTFRRW::TTFRRW ttfrrw;
+	ttfrrw.SetThreadCount(1U);
+	if (!ttfrrw.OpenFontFile(vFontFilePathName, flags))
+		return;
+	const size_t glyphCount = (size_t)ttfrrw.GetFontInfos().m_GlyphCount;
+
+	const char* parsers[] = { "Parse_CMAP_Table", "Parse_GLYF_Table" };
+	for (const auto& parser : parsers)
+	{
+		const std::string name = "info_logs/" + GetFileName(vFontFilePathName) + "/" + build + "/" + parser;
+		const std::string path = std::string("OpenFontFile/") + parser;
+		const bool isGlyf = (strcmp(parser, "Parse_GLYF_Table") == 0);
+		RunMeasured(name, vIterations, 0.0, isGlyf ? (double)glyphCount : 0.0, isGlyf ? "glyphs" : "", [&]()
+		{
+			TTFRRW::TimingRegistry::Entry entry;
+			if (ttfrrw.OpenFontFile(vFontFilePathName, flags) &&
+				ttfrrw.GetProfiler()->timings.GetEntry(path, &entry))
+				return entry.total;
+			return 0.0;
+		});
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+//// MACRO ////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+static void BenchOpen(const std::string& vFontFilePathName, const size_t& vIterations)
+{
+	struct FlagsMode
+	{
+		const char* name;
+		TTFRRW::ttfrrwProcessingFlags flags;
+		bool decodeGlyphs; // else no glyphs/s
+	};
+	const FlagsMode modes[] =
+	{
+		{ "full", TTFRRW::TTFRRW_PROCESSING_FLAG_NONE, true },
+		{ "no_glyph_parsing", TTFRRW::TTFRRW_PROCESSING_FLAG_NO_GLYPH_PARSING, false },
+		{ "lazy", TTFRRW::TTFRRW_PROCESSING_FLAG_LAZY_PARSING, false }, // only the table directory
+		{ "on_demand_glyphs", TTFRRW::TTFRRW_PROCESSING_FLAG_ON_DEMAND_GLYPHS, false }, // only the bbox of the glyphs
+	};
+
+	const size_t fileSize = GetFileSize(vFontFilePathName);
+
+	TTFRRW::TTFRRW ttfrrw;
+	if (!ttfrrw.OpenFontFile(vFontFilePathName, TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS))
+	{
+		printf("failed to open %s\n", vFontFilePathName.c_str());
+		return;
+	}
+	const size_t glyphCount = (size_t)ttfrrw.GetFontInfos().m_GlyphCount;
+
+	// 1, 2, 4... and all the threads of the pool
+	std::vector<size_t> threadCounts;
+	const size_t maxThreads = TTFRRW::ThreadPool::Instance()->GetThreadCount();
+	for (size_t threads = 1U; threads < maxThreads; threads *= 2U)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	for (const auto& mode : modes)
+	{
+		for (const auto& threads : threadCounts)
+		{
+			char name[256];
+			snprintf(name, sizeof(name), "open/%s/%s/threads_%u",
+				GetFileName(vFontFilePathName).c_str(), mode.name, (uint32_t)threads);
+
+			ttfrrw.SetThreadCount(threads);
+			Run(name, vIterations, (double)fileSize, mode.decodeGlyphs ? (double)glyphCount : 0.0, mode.decodeGlyphs ? "glyphs" : "", [&]()
+			{
+				ttfrrw.OpenFontFile(vFontFilePathName, mode.flags | TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS);
+			});
+		}
+	}
+}
+
+// throughput of FontBatch on a corpus of many fonts, the files are read in memory before
+// so the disk is not measured, the batch borrow the streams
+static void BenchBatch(const std::vector<std::string>& vFontFilePathNames, const size_t& vFontsCount, const size_t& vIterations)
+{
+	std::vector<std::vector<uint8_t>> files;
+	std::vector<size_t> glyphCounts;
+	for (const auto& fontFilePathName : vFontFilePathNames)
+	{
+		std::vector<uint8_t> file;
+		const bool readOk = ReadFile(fontFilePathName, &file);
+
+		TTFRRW::TTFRRW ttfrrw;
+		if (!readOk || !ttfrrw.OpenFontStream(file.data(), file.size(), TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS))
+		{
+			printf("failed to open %s\n", fontFilePathName.c_str());
+			return;
+		}
+		glyphCounts.push_back((size_t)ttfrrw.GetFontInfos().m_GlyphCount);
+		files.push_back(std::move(file));
+	}
+	if (files.empty() || !vFontsCount)
+		return;
+
+	TTFRRW::FontBatch batch;
+	double bytes = 0.0;
+	double glyphs = 0.0;
+	for (size_t idx = 0; idx < vFontsCount; idx++)
+	{
+		const auto& file = files[idx % files.size()];
+		batch.AddFontStream(file.data(), file.size());
+		bytes += (double)file.size();
+		glyphs += (double)glyphCounts[idx % files.size()];
+	}
+
+	// the fonts of the corpus stay in memory until the next open, so less iterations
+	const size_t iterations = TTFRRW::maxi(vIterations / 4U, (size_t)1U);
+	const size_t maxThreads = TTFRRW::ThreadPool::Instance()->GetThreadCount();
+	std::vector<size_t> threadCounts;
+	for (size_t threads = 1U; threads < maxThreads; threads *= 2U)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	for (const auto& threads : threadCounts)
+	{
+		char name[256];
+		snprintf(name, sizeof(name), "batch/fonts_%u/threads_%u", (uint32_t)vFontsCount, (uint32_t)threads);
+
+		batch.SetThreadCount(threads);
+		Run(name, iterations, bytes, glyphs, "glyphs", [&]()
+		{
+			s_Sink = batch.Open(TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS);
+		});
+	}
+	batch.Clear();
+}
+
+///////////////////////////////////////////////////////////////////////
+//// JSON /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// the names are made of the file names of the fonts
+static std::string EscapeJson(const std::string& vString)
+{
+	std::string res;
+	for (const auto& c : vString)
+	{
+		if (c == '"' || c == '\\')
+		{
+			res += '\\';
+			res += c;
+		}
+		else if ((unsigned char)c < 0x20U)
+		{
+			char buffer[8];
+			snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned int)(unsigned char)c);
+			res += buffer;
+		}
+		else
+		{
+			res += c;
+		}
+	}
+	return res;
+}
+
+static bool WriteJson(const std::string& vFilePathName, const TTFRRW::TimingRegistry& vTimings)
+{
+	FILE* file = fopen(vFilePathName.c_str(), "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\"benchmarks\":[\n");
+	for (size_t idx = 0; idx < s_Results.size(); idx++)
+	{
+		const auto& res = s_Results[idx];
+		const double mbPerSecond = (res.bytesPerIteration > 0.0 && res.medianSeconds > 0.0) ?
+			res.bytesPerIteration / res.medianSeconds / (1024.0 * 1024.0) : 0.0;
+		const double itemsPerSecond = (res.itemsPerIteration > 0.0 && res.medianSeconds > 0.0) ?
+			res.itemsPerIteration / res.medianSeconds : 0.0;
+		fprintf(file, "{\"name\":\"%s\",\"iterations\":%u,\"min_s\":%.9f,\"median_s\":%.9f,"
+			"\"mb_per_s\":%.3f,\"items_per_s\":%.1f,\"items_unit\":\"%s\",\"allocations\":%.1f}%s\n",
+			EscapeJson(res.name).c_str(), (uint32_t)res.iterations, res.minSeconds, res.medianSeconds,
+			mbPerSecond, itemsPerSecond, EscapeJson(res.itemsUnit).c_str(), res.allocationsPerIteration,
+			(idx + 1U < s_Results.size()) ? "," : "");
+	}
+	fprintf(file, "],\n\"tables\":%s}\n", vTimings.GetJson().c_str());
+	fclose(file);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+//// MAIN /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	size_t iterations = 20U;
+	size_t batchFontsCount = 300U;
+	bool infoLogsOnly = false;
+	std::string jsonFilePathName;
+	std::vector<std::string> fonts;
+	for (int idx = 1; idx < argc; idx++)
+	{
+		if (!strcmp(argv[idx], "-n") && idx + 1 < argc)
+			iterations = (size_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-batch") && idx + 1 < argc)
+			batchFontsCount = (size_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-info_logs"))
+			infoLogsOnly = true;
+		else if (!strcmp(argv[idx], "-o") && idx + 1 < argc)
+			jsonFilePathName = argv[++idx];
+		else
+			fonts.push_back(argv[idx]);
+	}
+	if (fonts.empty())
+	{
+		fonts.push_back(std::string(PROJECT_PATH) + "/testfont.ttf");
+		fonts.push_back(std::string(PROJECT_PATH) + "/testfont2_colr.ttf");
+	}
+
+	if (infoLogsOnly)
+	{
+		printf("---- info logs ----\n");
+		for (const auto& font : fonts)
+		{
+			BenchInfoLogs(font, iterations);
+		}
+		return 0;
+	}
+
+	printf("---- micro ----\n");
+	BenchMemoryStream(iterations);
+	for (const auto& font : fonts)
+	{
+		BenchCMAP(font, iterations);
+	}
+	for (const auto& font : fonts)
+	{
+		TTFRRW::ParserBench::BenchParsers(font, iterations);
+	}
+
+	TTFRRW::TimingRegistry tablesTimings;
+	for (const auto& font : fonts)
+	{
+		BenchTables(font, iterations, &tablesTimings);
+	}
+	printf("---- tables (parsers timings on %u opens) ----\n", (uint32_t)iterations);
+	for (const auto& entry : tablesTimings.GetEntries())
+	{
+		if (!entry.count)
+			continue;
+		printf("%-64s mean %12.3f us | p99 %12.3f us | count %llu\n", entry.path.c_str(),
+			entry.total / (double)entry.count * 1e6, entry.p99 * 1e6, (unsigned long long)entry.count);
+	}
+
+	printf("---- info logs ----\n");
+	for (const auto& font : fonts)
+	{
+		BenchInfoLogs(font, iterations);
+	}
+
+	printf("---- macro ----\n");
+	for (const auto& font : fonts)
+	{
+		BenchOpen(font, iterations);
+	}
+	BenchBatch(fonts, batchFontsCount, iterations);
+
+	if (!jsonFilePathName.empty())
+	{
+		if (WriteJson(jsonFilePathName, tablesTimings))
+			printf("results written in %s\n", jsonFilePathName.c_str());
+		else
+			printf("failed to write %s\n", jsonFilePathName.c_str());
+	}
+
+	return 0;
+}
@@ -0,0 +1,955 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+// generator of synthetic fonts, for measure how the costs scale with the font size
+// usage : ttfrrw_stressgen [options] [-o stress.ttf]
+//	-glyphs N			glyph count, .notdef included (max 65535)
+//	-points N			points per glyph (max 65535)
+//	-contours N			contours per glyph
+//	-codepoints N		mapped codepoints, from U+0020, the surrogates are skipped
+//	-cmap-stride N		step between two mapped codepoints, 1 => dense cmap
+//	-variations N		variation sequences of the selector U+FE00 (cmap format 14)
+//	-colr-glyphs N		color glyphs (COLR)
+//	-layers N			layers per color glyph
+//	-palettes N			palettes (CPAL)
+//	-palette-entries N	colors per palette
+//	-seed N				seed of the outlines jitter
+// the generated font is opened with TTFRRW for check it
+
+#include "ttfrrw.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <map>
+
+///////////////////////////////////////////////////////////////////////
+//// PARAMS ///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+struct StressParams
+{
+	uint32_t glyphCount = 65535U;
+	uint32_t pointsPerGlyph = 64U;
+	uint32_t contoursPerGlyph = 2U;
+	uint32_t codePointsCount = 65534U;
+	uint32_t cmapStride = 1U;
+	uint32_t variationsCount = 0U;
+	uint32_t colrGlyphsCount = 0U;
+	uint32_t layersPerGlyph = 0U;
+	uint32_t palettesCount = 1U;
+	uint32_t paletteEntriesCount = 16U;
+	uint32_t seed = 1U;
+	std::string outputFilePathName = "stress.ttf";
+};
+
+// the limits of the tables
+static void ClampParams(StressParams* vParams)
+{
+	vParams->glyphCount = TTFRRW::mini(TTFRRW::maxi(vParams->glyphCount, 2U), 65535U);
+	vParams->contoursPerGlyph = TTFRRW::maxi(vParams->contoursPerGlyph, 1U);
+	vParams->pointsPerGlyph = TTFRRW::mini(TTFRRW::maxi(vParams->pointsPerGlyph, vParams->contoursPerGlyph * 3U), 65535U);
+	vParams->cmapStride = TTFRRW::maxi(vParams->cmapStride, 1U);
+	vParams->colrGlyphsCount = TTFRRW::mini(vParams->colrGlyphsCount, vParams->glyphCount - 1U);
+	if (vParams->colrGlyphsCount && vParams->layersPerGlyph)
+	{
+		// firstLayerIndex and numLayerRecords are 16 bits
+		const uint32_t maxColrGlyphs = 65535U / vParams->layersPerGlyph;
+		if (vParams->colrGlyphsCount > maxColrGlyphs)
+		{
+			printf("COLR : %u color glyphs of %u layers are too much, %u are kept\n",
+				vParams->colrGlyphsCount, vParams->layersPerGlyph, maxColrGlyphs);
+			vParams->colrGlyphsCount = maxColrGlyphs;
+		}
+	}
+	else
+	{
+		vParams->colrGlyphsCount = 0U;
+		vParams->layersPerGlyph = 0U;
+	}
+	vParams->palettesCount = TTFRRW::maxi(vParams->palettesCount, 1U);
+	vParams->paletteEntriesCount = TTFRRW::maxi(vParams->paletteEntriesCount, 1U);
+	if (vParams->palettesCount * vParams->paletteEntriesCount > 65535U) // numColorRecords is 16 bits
+	{
+		vParams->palettesCount = TTFRRW::maxi(65535U / vParams->paletteEntriesCount, 1U);
+		vParams->paletteEntriesCount = TTFRRW::mini(vParams->paletteEntriesCount, 65535U);
+		printf("CPAL : too much colors, %u palettes are kept\n", vParams->palettesCount);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+//// GLYPHS ///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+struct StressPoint
+{
+	int16_t x = 0;
+	int16_t y = 0;
+	bool onCurve = true;
+};
+
+typedef std::vector<std::vector<StressPoint>> StressContours;
+
+struct StressBBox
+{
+	int16_t xMin = 32767;
+	int16_t yMin = 32767;
+	int16_t xMax = -32768;
+	int16_t yMax = -32768;
+
+	void Combine(const StressBBox& vBBox)
+	{
+		xMin = TTFRRW::mini(xMin, vBBox.xMin);
+		yMin = TTFRRW::mini(yMin, vBBox.yMin);
+		xMax = TTFRRW::maxi(xMax, vBBox.xMax);
+		yMax = TTFRRW::maxi(yMax, vBBox.yMax);
+	}
+};
+
+// the glyph tables built together, the loca need the glyf offsets, the hmtx and maxp the outlines
+struct StressGlyphs
+{
+	TTFRRW::MemoryStream glyf;
+	std::vector<uint32_t> offsets; // glyph count + 1
+	std::vector<StressBBox> bboxes;
+	StressBBox globalBBox;
+	uint32_t maxPoints = 0U;
+	uint32_t maxContours = 0U;
+};
+
+// lcg, the fonts must be the same for a seed on all the platforms
+static float GetRandom(uint32_t* vSeed)
+{
+	*vSeed = *vSeed * 1664525U + 1013904223U;
+	return (float)(*vSeed >> 8) / (float)(1U << 24);
+}
+
+// concentric stars, the on and off curve points alternate
+static StressContours GetGlyphContours(const StressParams& vParams, uint32_t* vSeed)
+{
+	const uint32_t contoursCount = vParams.contoursPerGlyph;
+	StressContours contours(contoursCount);
+	for (uint32_t contourID = 0; contourID < contoursCount; contourID++)
+	{
+		// the remaining points go in the last contour
+		uint32_t pointsCount = vParams.pointsPerGlyph / contoursCount;
+		if (contourID + 1U == contoursCount)
+			pointsCount = vParams.pointsPerGlyph - pointsCount * (contoursCount - 1U);
+
+		const float radius = TTFRRW::maxi(450.0f * (float)(contoursCount - contourID) / (float)contoursCount, 10.0f);
+		const float angleOffset = GetRandom(vSeed) * 6.2831853f;
+		auto& contour = contours[contourID];
+		contour.resize(pointsCount);
+		for (uint32_t pointID = 0; pointID < pointsCount; pointID++)
+		{
+			const float angle = angleOffset + 6.2831853f * (float)pointID / (float)pointsCount;
+			const float jitter = 0.9f + 0.2f * GetRandom(vSeed);
+			auto& point = contour[pointID];
+			point.x = (int16_t)lroundf(500.0f + cosf(angle) * radius * jitter);
+			point.y = (int16_t)lroundf(300.0f + sinf(angle) * radius * jitter);
+			point.onCurve = ((pointID % 2U) == 0U);
+		}
+	}
+	return contours;
+}
+
+static StressContours GetNotdefContours()
+{
+	StressContours contours(1U);
+	StressPoint point;
+	point.x = 100; point.y = 0; contours[0].push_back(point);
+	point.x = 100; point.y = 700; contours[0].push_back(point);
+	point.x = 600; point.y = 700; contours[0].push_back(point);
+	point.x = 600; point.y = 0; contours[0].push_back(point);
+	return contours;
+}
+
+#define FLAG_ON_CURVE 0x01
+#define FLAG_X_SHORT 0x02
+#define FLAG_Y_SHORT 0x04
+#define FLAG_REPEAT 0x08
+#define FLAG_X_SAME_OR_POSITIVE 0x10
+#define FLAG_Y_SAME_OR_POSITIVE 0x20
+
+// the deltas are packed like in a real font, for exercise the short and repeat paths of the decoder
+static uint8_t GetDeltaFlag(const int32_t& vDelta, const uint8_t& vShortFlag, const uint8_t& vSameOrPositiveFlag)
+{
+	if (vDelta == 0)
+		return vSameOrPositiveFlag;
+	if (vDelta > -256 && vDelta < 256)
+		return (uint8_t)(vShortFlag | ((vDelta > 0) ? vSameOrPositiveFlag : 0U));
+	return 0U;
+}
+
+static void WriteDelta(TTFRRW::MemoryStream* vMem, const int32_t& vDelta, const uint8_t& vFlag, const uint8_t& vShortFlag)
+{
+	if (vFlag & vShortFlag)
+		vMem->WriteByte((uint8_t)std::abs(vDelta));
+	else if (vDelta)
+		vMem->WriteShort(vDelta);
+}
+
+static StressBBox WriteSimpleGlyph(TTFRRW::MemoryStream* vMem, const StressContours& vContours)
+{
+	StressBBox bbox;
+	std::vector<StressPoint> points;
+	for (const auto& contour : vContours)
+	{
+		for (const auto& point : contour)
+		{
+			bbox.xMin = TTFRRW::mini(bbox.xMin, point.x);
+			bbox.yMin = TTFRRW::mini(bbox.yMin, point.y);
+			bbox.xMax = TTFRRW::maxi(bbox.xMax, point.x);
+			bbox.yMax = TTFRRW::maxi(bbox.yMax, point.y);
+			points.push_back(point);
+		}
+	}
+
+	vMem->WriteShort((int32_t)vContours.size()); // numberOfContours
+	vMem->WriteFWord(bbox.xMin);
+	vMem->WriteFWord(bbox.yMin);
+	vMem->WriteFWord(bbox.xMax);
+	vMem->WriteFWord(bbox.yMax);
+	uint32_t endPoint = 0U;
+	for (const auto& contour : vContours)
+	{
+		endPoint += (uint32_t)contour.size();
+		vMem->WriteUShort((int32_t)endPoint - 1); // endPtsOfContours
+	}
+	vMem->WriteUShort(0); // instructionLength
+
+	std::vector<uint8_t> flags(points.size());
+	int32_t lastX = 0, lastY = 0;
+	for (size_t idx = 0; idx < points.size(); idx++)
+	{
+		const int32_t dx = (int32_t)points[idx].x - lastX;
+		const int32_t dy = (int32_t)points[idx].y - lastY;
+		flags[idx] = (uint8_t)((points[idx].onCurve ? FLAG_ON_CURVE : 0U) |
+			GetDeltaFlag(dx, FLAG_X_SHORT, FLAG_X_SAME_OR_POSITIVE) |
+			GetDeltaFlag(dy, FLAG_Y_SHORT, FLAG_Y_SAME_OR_POSITIVE));
+		lastX = points[idx].x;
+		lastY = points[idx].y;
+	}
+
+	// flags
+	for (size_t idx = 0; idx < flags.size();)
+	{
+		size_t repeat = 0U;
+		while (idx + repeat + 1U < flags.size() && flags[idx + repeat + 1U] == flags[idx] && repeat < 255U)
+			repeat++;
+		if (repeat)
+		{
+			vMem->WriteByte((uint8_t)(flags[idx] | FLAG_REPEAT));
+			vMem->WriteByte((uint8_t)repeat);
+		}
+		else
+		{
+			vMem->WriteByte(flags[idx]);
+		}
+		idx += repeat + 1U;
+	}
+
+	// xCoordinates then yCoordinates
+	lastX = 0;
+	for (size_t idx = 0; idx < points.size(); idx++)
+	{
+		WriteDelta(vMem, (int32_t)points[idx].x - lastX, flags[idx], FLAG_X_SHORT);
+		lastX = points[idx].x;
+	}
+	lastY = 0;
+	for (size_t idx = 0; idx < points.size(); idx++)
+	{
+		WriteDelta(vMem, (int32_t)points[idx].y - lastY, flags[idx], FLAG_Y_SHORT);
+		lastY = points[idx].y;
+	}
+
+	return bbox;
+}
+
+static void BuildGlyphs(const StressParams& vParams, StressGlyphs* vOutGlyphs)
+{
+	uint32_t seed = vParams.seed;
+	vOutGlyphs->offsets.reserve(vParams.glyphCount + 1U);
+	vOutGlyphs->bboxes.reserve(vParams.glyphCount);
+	for (uint32_t glyphID = 0; glyphID < vParams.glyphCount; glyphID++)
+	{
+		const StressContours contours = glyphID ? GetGlyphContours(vParams, &seed) : GetNotdefContours();
+
+		uint32_t pointsCount = 0U;
+		for (const auto& contour : contours)
+			pointsCount += (uint32_t)contour.size();
+		vOutGlyphs->maxPoints = TTFRRW::maxi(vOutGlyphs->maxPoints, pointsCount);
+		vOutGlyphs->maxContours = TTFRRW::maxi(vOutGlyphs->maxContours, (uint32_t)contours.size());
+
+		vOutGlyphs->offsets.push_back((uint32_t)vOutGlyphs->glyf.GetSize());
+		const StressBBox bbox = WriteSimpleGlyph(&vOutGlyphs->glyf, contours);
+		vOutGlyphs->bboxes.push_back(bbox);
+		vOutGlyphs->globalBBox.Combine(bbox);
+
+		// the short loca need even offsets
+		while (vOutGlyphs->glyf.GetSize() % 4U)
+			vOutGlyphs->glyf.WriteByte(0U);
+	}
+	vOutGlyphs->offsets.push_back((uint32_t)vOutGlyphs->glyf.GetSize());
+}
+
+///////////////////////////////////////////////////////////////////////
+//// TABLES ///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+static TTFRRW::MemoryStream::Fixed GetFixed(const int16_t& vHigh, const int16_t& vLow)
+{
+	TTFRRW::MemoryStream::Fixed res;
+	res.high = vHigh;
+	res.low = vLow;
+	return res;
+}
+
+static int16_t GetIndexToLocFormat(const StressGlyphs& vGlyphs)
+{
+	return (vGlyphs.glyf.GetSize() / 2U > 0xFFFFU) ? 1 : 0;
+}
+
+static TTFRRW::MemoryStream Assemble_HEAD_Table(const StressGlyphs& vGlyphs, const uint32_t& vCheckSumAdjustment)
+{
+	TTFRRW::MemoryStream mem;
+	mem.WriteFixed(GetFixed(1, 0)); // version
+	mem.WriteFixed(GetFixed(1, 0)); // fontRevision
+	mem.WriteULong(vCheckSumAdjustment);
+	mem.WriteULong(0x5F0F3CF5); // magicNumber
+	mem.WriteUShort(0x0003); // flags : baseline and lsb at 0
+	mem.WriteUShort(1000); // unitsPerEm
+	mem.WriteDateTime(0); // created
+	mem.WriteDateTime(0); // modified
+	mem.WriteFWord(vGlyphs.globalBBox.xMin);
+	mem.WriteFWord(vGlyphs.globalBBox.yMin);
+	mem.WriteFWord(vGlyphs.globalBBox.xMax);
+	mem.WriteFWord(vGlyphs.globalBBox.yMax);
+	mem.WriteUShort(0); // macStyle
+	mem.WriteUShort(8); // lowestRecPPEM
+	mem.WriteShort(2); // fontDirectionHint
+	mem.WriteShort(GetIndexToLocFormat(vGlyphs));
+	mem.WriteShort(0); // glyphDataFormat
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_HHEA_Table(const StressParams& vParams, const StressGlyphs& vGlyphs)
+{
+	TTFRRW::MemoryStream mem;
+	mem.WriteFixed(GetFixed(1, 0)); // version
+	mem.WriteFWord(800); // ascender
+	mem.WriteFWord(-200); // descender
+	mem.WriteFWord(0); // lineGap
+	mem.WriteUFWord(1000); // advanceWidthMax
+	mem.WriteFWord(vGlyphs.globalBBox.xMin); // minLeftSideBearing
+	mem.WriteFWord(1000 - vGlyphs.globalBBox.xMax); // minRightSideBearing
+	mem.WriteFWord(vGlyphs.globalBBox.xMax); // xMaxExtent
+	mem.WriteShort(1); // caretSlopeRise
+	mem.WriteShort(0); // caretSlopeRun
+	mem.WriteShort(0); // caretOffset
+	for (size_t idx = 0; idx < 4U; idx++)
+		mem.WriteShort(0); // reserved
+	mem.WriteShort(0); // metricDataFormat
+	mem.WriteUShort((int32_t)vParams.glyphCount); // numberOfHMetrics
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_MAXP_Table(const StressParams& vParams, const StressGlyphs& vGlyphs)
+{
+	TTFRRW::MemoryStream mem;
+	mem.WriteFixed(GetFixed(1, 0)); // version
+	mem.WriteUShort((int32_t)vParams.glyphCount);
+	mem.WriteUShort((int32_t)vGlyphs.maxPoints);
+	mem.WriteUShort((int32_t)vGlyphs.maxContours);
+	mem.WriteUShort(0); // maxComponentPoints
+	mem.WriteUShort(0); // maxComponentContours
+	mem.WriteUShort(2); // maxZones
+	for (size_t idx = 0; idx < 8U; idx++)
+		mem.WriteUShort(0); // twilight points, storage, defs, stack, instructions and components
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_OS2_Table(const std::vector<TTFRRW::CodePoint>& vCodePoints)
+{
+	const uint32_t firstCodePoint = vCodePoints.empty() ? 0U : vCodePoints.front();
+	const uint32_t lastCodePoint = vCodePoints.empty() ? 0U : vCodePoints.back();
+
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(4); // version
+	mem.WriteShort(1000); // xAvgCharWidth
+	mem.WriteUShort(400); // usWeightClass
+	mem.WriteUShort(5); // usWidthClass
+	mem.WriteUShort(0); // fsType
+	mem.WriteShort(650); mem.WriteShort(600); mem.WriteShort(0); mem.WriteShort(75); // subscript
+	mem.WriteShort(650); mem.WriteShort(600); mem.WriteShort(0); mem.WriteShort(350); // superscript
+	mem.WriteShort(50); // yStrikeoutSize
+	mem.WriteShort(250); // yStrikeoutPosition
+	mem.WriteShort(0); // sFamilyClass
+	for (size_t idx = 0; idx < 10U; idx++)
+		mem.WriteByte(0U); // panose
+	for (size_t idx = 0; idx < 4U; idx++)
+		mem.WriteULong(0); // ulUnicodeRange
+	mem.WriteTag("NONE"); // achVendID
+	mem.WriteUShort(0x0040); // fsSelection : regular
+	mem.WriteUShort((int32_t)TTFRRW::mini(firstCodePoint, 0xFFFFU)); // usFirstCharIndex
+	mem.WriteUShort((int32_t)TTFRRW::mini(lastCodePoint, 0xFFFFU)); // usLastCharIndex
+	mem.WriteShort(800); // sTypoAscender
+	mem.WriteShort(-200); // sTypoDescender
+	mem.WriteShort(0); // sTypoLineGap
+	mem.WriteUShort(800); // usWinAscent
+	mem.WriteUShort(200); // usWinDescent
+	mem.WriteULong(1); // ulCodePageRange1 : latin 1
+	mem.WriteULong(0); // ulCodePageRange2
+	mem.WriteShort(500); // sxHeight
+	mem.WriteShort(700); // sCapHeight
+	mem.WriteUShort(0); // usDefaultChar
+	mem.WriteUShort(0x20); // usBreakChar
+	mem.WriteUShort(1); // usMaxContext
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_HMTX_Table(const StressGlyphs& vGlyphs)
+{
+	TTFRRW::MemoryStream mem;
+	for (const auto& bbox : vGlyphs.bboxes)
+	{
+		mem.WriteUShort(1000); // advanceWidth
+		mem.WriteShort(bbox.xMin); // lsb
+	}
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_LOCA_Table(const StressGlyphs& vGlyphs)
+{
+	TTFRRW::MemoryStream mem;
+	const bool isLong = (GetIndexToLocFormat(vGlyphs) == 1);
+	for (const auto& offset : vGlyphs.offsets)
+	{
+		if (isLong)
+			mem.WriteULong(offset);
+		else
+			mem.WriteUShort((int32_t)(offset / 2U));
+	}
+	return mem;
+}
+
+// mapped from U+0020, the surrogates are not characters
+static std::vector<TTFRRW::CodePoint> GetCodePoints(const StressParams& vParams)
+{
+	std::vector<TTFRRW::CodePoint> res;
+	res.reserve(vParams.codePointsCount);
+	uint32_t codePoint = 0x20U;
+	while (res.size() < vParams.codePointsCount && codePoint <= 0x10FFFFU)
+	{
+		if (codePoint >= 0xD800U && codePoint <= 0xDFFFU)
+		{
+			codePoint = 0xE000U;
+			continue;
+		}
+		if (codePoint != 0xFFFFU) // the end of the format 4
+			res.push_back((TTFRRW::CodePoint)codePoint);
+		codePoint += vParams.cmapStride;
+	}
+	return res;
+}
+
+// the glyph of the codepoint idx, .notdef excepted
+static TTFRRW::GlyphIndex GetGlyphIndexOfCodePoint(const StressParams& vParams, const size_t& vCodePointIdx)
+{
+	return (TTFRRW::GlyphIndex)(1U + vCodePointIdx % (vParams.glyphCount - 1U));
+}
+
+// consecutive codepoints on consecutive glyphs
+struct CodePointsGroup
+{
+	uint32_t startCodePoint = 0U;
+	uint32_t endCodePoint = 0U;
+	uint32_t startGlyphID = 0U;
+};
+
+static std::vector<CodePointsGroup> GetCodePointsGroups(const StressParams& vParams, const std::vector<TTFRRW::CodePoint>& vCodePoints)
+{
+	std::vector<CodePointsGroup> res;
+	for (size_t idx = 0; idx < vCodePoints.size(); idx++)
+	{
+		const uint32_t glyphID = GetGlyphIndexOfCodePoint(vParams, idx);
+		if (!res.empty() &&
+			res.back().endCodePoint + 1U == vCodePoints[idx] &&
+			res.back().startGlyphID + (res.back().endCodePoint - res.back().startCodePoint) + 1U == glyphID)
+		{
+			res.back().endCodePoint = vCodePoints[idx];
+		}
+		else
+		{
+			CodePointsGroup group;
+			group.startCodePoint = vCodePoints[idx];
+			group.endCodePoint = vCodePoints[idx];
+			group.startGlyphID = glyphID;
+			res.push_back(group);
+		}
+	}
+	return res;
+}
+
+// the bmp segments, the length of the subtable is 16 bits, so the segments count is limited
+static TTFRRW::MemoryStream Assemble_CMAP_Format4(const std::vector<CodePointsGroup>& vGroups)
+{
+	const size_t maxSegments = (0xFFFFU - 16U) / 8U - 1U;
+	std::vector<CodePointsGroup> segments;
+	for (const auto& group : vGroups)
+	{
+		if (group.startCodePoint > 0xFFFFU)
+			break;
+		if (segments.size() == maxSegments)
+		{
+			printf("CMAP : format 4 limited to %u segments, format 12 have all the codepoints\n", (uint32_t)maxSegments);
+			break;
+		}
+		CodePointsGroup segment = group;
+		segment.endCodePoint = TTFRRW::mini(segment.endCodePoint, 0xFFFEU);
+		segments.push_back(segment);
+	}
+	CodePointsGroup lastSegment; // required
+	lastSegment.startCodePoint = 0xFFFFU;
+	lastSegment.endCodePoint = 0xFFFFU;
+	lastSegment.startGlyphID = 0U;
+	segments.push_back(lastSegment);
+
+	const size_t segCount = segments.size();
+	size_t searchRange = 2U, entrySelector = 0U;
+	while (searchRange * 2U <= segCount * 2U)
+	{
+		searchRange *= 2U;
+		entrySelector++;
+	}
+
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(4); // format
+	mem.WriteUShort((int32_t)(16U + 8U * segCount)); // length
+	mem.WriteUShort(0); // language
+	mem.WriteUShort((int32_t)(segCount * 2U));
+	mem.WriteUShort((int32_t)searchRange);
+	mem.WriteUShort((int32_t)entrySelector);
+	mem.WriteUShort((int32_t)(segCount * 2U - searchRange)); // rangeShift
+	for (const auto& segment : segments)
+		mem.WriteUShort((int32_t)segment.endCodePoint);
+	mem.WriteUShort(0); // reservedPad
+	for (const auto& segment : segments)
+		mem.WriteUShort((int32_t)segment.startCodePoint);
+	for (const auto& segment : segments)
+		mem.WriteShort((int32_t)((segment.startGlyphID - segment.startCodePoint) & 0xFFFFU)); // idDelta, modulo 65536
+	for (size_t idx = 0; idx < segCount; idx++)
+		mem.WriteUShort(0); // idRangeOffset
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_CMAP_Format12(const std::vector<CodePointsGroup>& vGroups)
+{
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(12); // format
+	mem.WriteUShort(0); // reserved
+	mem.WriteULong((int64_t)(16U + 12U * vGroups.size())); // length
+	mem.WriteULong(0); // language
+	mem.WriteULong((int64_t)vGroups.size());
+	for (const auto& group : vGroups)
+	{
+		mem.WriteULong(group.startCodePoint);
+		mem.WriteULong(group.endCodePoint);
+		mem.WriteULong(group.startGlyphID);
+	}
+	return mem;
+}
+
+// the first codepoints with the selector U+FE00 use the next glyph
+static TTFRRW::MemoryStream Assemble_CMAP_Format14(const StressParams& vParams, const std::vector<TTFRRW::CodePoint>& vCodePoints)
+{
+	const size_t mappingsCount = TTFRRW::mini((size_t)vParams.variationsCount, vCodePoints.size());
+
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(14); // format
+	mem.WriteULong((int64_t)(10U + 11U + 4U + 5U * mappingsCount)); // length
+	mem.WriteULong(1); // numVarSelectorRecords
+	mem.WriteUInt24(0xFE00); // varSelector
+	mem.WriteULong(0); // defaultUVSOffset
+	mem.WriteULong(10U + 11U); // nonDefaultUVSOffset
+	mem.WriteULong((int64_t)mappingsCount);
+	for (size_t idx = 0; idx < mappingsCount; idx++)
+	{
+		mem.WriteUInt24((int32_t)vCodePoints[idx]);
+		mem.WriteUShort((int32_t)((GetGlyphIndexOfCodePoint(vParams, idx) + 1U) % vParams.glyphCount));
+	}
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_CMAP_Table(const StressParams& vParams, const std::vector<TTFRRW::CodePoint>& vCodePoints)
+{
+	const std::vector<CodePointsGroup> groups = GetCodePointsGroups(vParams, vCodePoints);
+	const TTFRRW::MemoryStream format4 = Assemble_CMAP_Format4(groups);
+	const TTFRRW::MemoryStream format12 = Assemble_CMAP_Format12(groups);
+	TTFRRW::MemoryStream format14;
+	if (vParams.variationsCount)
+		format14 = Assemble_CMAP_Format14(vParams, vCodePoints);
+
+	// the records are sorted by platform and encoding
+	struct EncodingRecord
+	{
+		uint16_t platformID;
+		uint16_t encodingID;
+		const TTFRRW::MemoryStream* subtable;
+	};
+	std::vector<EncodingRecord> records;
+	records.push_back({ 0U, 3U, &format4 }); // unicode bmp
+	if (format14.GetSize())
+		records.push_back({ 0U, 5U, &format14 }); // unicode variation sequences
+	records.push_back({ 3U, 1U, &format4 }); // windows unicode bmp
+	records.push_back({ 3U, 10U, &format12 }); // windows unicode full
+
+	// the format 4 is shared by two records
+	const size_t format4Offset = 4U + 8U * records.size();
+	const size_t format12Offset = format4Offset + format4.GetSize();
+	const size_t format14Offset = format12Offset + format12.GetSize();
+
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(0); // version
+	mem.WriteUShort((int32_t)records.size());
+	for (const auto& record : records)
+	{
+		mem.WriteUShort(record.platformID);
+		mem.WriteUShort(record.encodingID);
+		if (record.subtable == &format4)
+			mem.WriteULong((int64_t)format4Offset);
+		else if (record.subtable == &format12)
+			mem.WriteULong((int64_t)format12Offset);
+		else
+			mem.WriteULong((int64_t)format14Offset);
+	}
+	mem.AppendMemoryStream(format4);
+	mem.AppendMemoryStream(format12);
+	mem.AppendMemoryStream(format14);
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_POST_Table()
+{
+	TTFRRW::MemoryStream mem;
+	mem.WriteFixed(GetFixed(3, 0)); // version 3, no glyph names
+	mem.WriteFixed(GetFixed(0, 0)); // italicAngle
+	mem.WriteFWord(-100); // underlinePosition
+	mem.WriteFWord(50); // underlineThickness
+	mem.WriteULong(0); // isFixedPitch
+	for (size_t idx = 0; idx < 4U; idx++)
+		mem.WriteULong(0); // min and max memory of type 42 and type 1
+	return mem;
+}
+
+// mac roman and windows unicode records
+static TTFRRW::MemoryStream Assemble_NAME_Table()
+{
+	const std::vector<std::pair<uint16_t, std::string>> names =
+	{
+		{ 1U, "TTFRRW Stress" }, // family
+		{ 2U, "Regular" }, // subfamily
+		{ 4U, "TTFRRW Stress Regular" }, // full name
+		{ 6U, "TTFRRW-Stress" }, // postscript name
+	};
+
+	TTFRRW::MemoryStream storage;
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(0); // version
+	mem.WriteUShort((int32_t)(names.size() * 2U));
+	mem.WriteUShort((int32_t)(6U + 12U * names.size() * 2U)); // storageOffset
+	for (const uint16_t platformID : { 1U, 3U })
+	{
+		for (const auto& name : names)
+		{
+			const size_t stringOffset = storage.GetSize();
+			if (platformID == 3U) // utf16 be
+			{
+				for (const auto& c : name.second)
+				{
+					storage.WriteByte(0U);
+					storage.WriteByte((uint8_t)c);
+				}
+			}
+			else
+			{
+				storage.WriteString(name.second);
+			}
+			mem.WriteUShort(platformID);
+			mem.WriteUShort((platformID == 3U) ? 1 : 0); // encodingID
+			mem.WriteUShort((platformID == 3U) ? 0x409 : 0); // languageID
+			mem.WriteUShort(name.first);
+			mem.WriteUShort((int32_t)(storage.GetSize() - stringOffset)); // length
+			mem.WriteUShort((int32_t)stringOffset);
+		}
+	}
+	mem.AppendMemoryStream(storage);
+	return mem;
+}
+
+// version 0, the layers of a color glyph are the next glyphs
+static TTFRRW::MemoryStream Assemble_COLR_Table(const StressParams& vParams)
+{
+	const uint32_t layersCount = vParams.colrGlyphsCount * vParams.layersPerGlyph;
+
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(0); // version
+	mem.WriteUShort((int32_t)vParams.colrGlyphsCount); // numBaseGlyphRecords
+	mem.WriteULong(14); // baseGlyphRecordsOffset
+	mem.WriteULong((int64_t)(14U + 6U * vParams.colrGlyphsCount)); // layerRecordsOffset
+	mem.WriteUShort((int32_t)layersCount); // numLayerRecords
+	for (uint32_t colrGlyphID = 0; colrGlyphID < vParams.colrGlyphsCount; colrGlyphID++)
+	{
+		mem.WriteUShort((int32_t)(1U + colrGlyphID)); // glyphID, sorted
+		mem.WriteUShort((int32_t)(colrGlyphID * vParams.layersPerGlyph)); // firstLayerIndex
+		mem.WriteUShort((int32_t)vParams.layersPerGlyph); // numLayers
+	}
+	for (uint32_t colrGlyphID = 0; colrGlyphID < vParams.colrGlyphsCount; colrGlyphID++)
+	{
+		for (uint32_t layerID = 0; layerID < vParams.layersPerGlyph; layerID++)
+		{
+			mem.WriteUShort((int32_t)(1U + (colrGlyphID + 1U + layerID) % (vParams.glyphCount - 1U))); // glyphID
+			mem.WriteUShort((int32_t)(layerID % vParams.paletteEntriesCount)); // paletteIndex
+		}
+	}
+	return mem;
+}
+
+static TTFRRW::MemoryStream Assemble_CPAL_Table(const StressParams& vParams, uint32_t* vSeed)
+{
+	const uint32_t colorsCount = vParams.palettesCount * vParams.paletteEntriesCount;
+
+	TTFRRW::MemoryStream mem;
+	mem.WriteUShort(0); // version
+	mem.WriteUShort((int32_t)vParams.paletteEntriesCount);
+	mem.WriteUShort((int32_t)vParams.palettesCount);
+	mem.WriteUShort((int32_t)colorsCount); // numColorRecords
+	mem.WriteULong((int64_t)(12U + 2U * vParams.palettesCount)); // colorRecordsArrayOffset
+	for (uint32_t paletteID = 0; paletteID < vParams.palettesCount; paletteID++)
+		mem.WriteUShort((int32_t)(paletteID * vParams.paletteEntriesCount)); // colorRecordIndices
+	for (uint32_t colorID = 0; colorID < colorsCount; colorID++)
+	{
+		mem.WriteByte((uint8_t)(GetRandom(vSeed) * 255.0f)); // B
+		mem.WriteByte((uint8_t)(GetRandom(vSeed) * 255.0f)); // G
+		mem.WriteByte((uint8_t)(GetRandom(vSeed) * 255.0f)); // R
+		mem.WriteByte(255U); // A
+	}
+	return mem;
+}
+
+///////////////////////////////////////////////////////////////////////
+//// FONT /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// sum of the big endian uint32, the last one is padded with zeros
+static uint32_t GetCheckSum(const TTFRRW::MemoryStream& vMem)
+{
+	const uint8_t* datas = vMem.GetDatas();
+	const size_t size = vMem.GetSize();
+	uint32_t res = 0U;
+	for (size_t idx = 0; idx < size; idx += 4U)
+	{
+		uint32_t value = 0U;
+		for (size_t byteID = 0; byteID < 4U; byteID++)
+		{
+			value <<= 8U;
+			if (idx + byteID < size)
+				value |= datas[idx + byteID];
+		}
+		res += value;
+	}
+	return res;
+}
+
+// the tables are sorted by tag in the map, like the table records must be
+static TTFRRW::MemoryStream Assemble_Font(const std::map<std::string, TTFRRW::MemoryStream>& vTables,
+	const std::map<std::string, uint32_t>& vCheckSums)
+{
+	const size_t numTables = vTables.size();
+	size_t searchRange = 16U, entrySelector = 0U;
+	while (searchRange * 2U <= numTables * 16U)
+	{
+		searchRange *= 2U;
+		entrySelector++;
+	}
+
+	TTFRRW::MemoryStream mem;
+	mem.WriteULong(0x00010000); // sfntVersion, truetype outlines
+	mem.WriteUShort((int32_t)numTables);
+	mem.WriteUShort((int32_t)searchRange);
+	mem.WriteUShort((int32_t)entrySelector);
+	mem.WriteUShort((int32_t)(numTables * 16U - searchRange)); // rangeShift
+
+	size_t offset = 12U + 16U * numTables;
+	for (const auto& table : vTables)
+	{
+		mem.WriteTag(table.first);
+		mem.WriteULong(vCheckSums.at(table.first));
+		mem.WriteULong((int64_t)offset);
+		mem.WriteULong((int64_t)table.second.GetSize());
+		offset += (table.second.GetSize() + 3U) & ~(size_t)3U;
+	}
+	for (const auto& table : vTables)
+	{
+		mem.AppendMemoryStream(table.second);
+		while (mem.GetSize() % 4U)
+			mem.WriteByte(0U);
+	}
+	return mem;
+}
+
+static bool WriteFile(const std::string& vFilePathName, const TTFRRW::MemoryStream& vMem)
+{
+	FILE* file = fopen(vFilePathName.c_str(), "wb");
+	if (!file)
+		return false;
+	const size_t written = fwrite(vMem.GetDatas(), 1U, vMem.GetSize(), file);
+	fclose(file);
+	return (written == vMem.GetSize());
+}
+
+static TTFRRW::MemoryStream GenerateFont(const StressParams& vParams)
+{
+	StressGlyphs glyphs;
+	BuildGlyphs(vParams, &glyphs);
+	const std::vector<TTFRRW::CodePoint> codePoints = GetCodePoints(vParams);
+
+	std::map<std::string, TTFRRW::MemoryStream> tables;
+	tables["head"] = Assemble_HEAD_Table(glyphs, 0U);
+	tables["hhea"] = Assemble_HHEA_Table(vParams, glyphs);
+	tables["maxp"] = Assemble_MAXP_Table(vParams, glyphs);
+	tables["OS/2"] = Assemble_OS2_Table(codePoints);
+	tables["hmtx"] = Assemble_HMTX_Table(glyphs);
+	tables["cmap"] = Assemble_CMAP_Table(vParams, codePoints);
+	tables["loca"] = Assemble_LOCA_Table(glyphs);
+	tables["glyf"] = glyphs.glyf;
+	tables["post"] = Assemble_POST_Table();
+	tables["name"] = Assemble_NAME_Table();
+	if (vParams.colrGlyphsCount)
+	{
+		uint32_t seed = vParams.seed;
+		tables["COLR"] = Assemble_COLR_Table(vParams);
+		tables["CPAL"] = Assemble_CPAL_Table(vParams, &seed);
+	}
+
+	// the checksum of head is computed with a null checkSumAdjustment
+	std::map<std::string, uint32_t> checkSums;
+	for (const auto& table : tables)
+		checkSums[table.first] = GetCheckSum(table.second);
+	const uint32_t fontCheckSum = GetCheckSum(Assemble_Font(tables, checkSums));
+	tables["head"] = Assemble_HEAD_Table(glyphs, 0xB1B0AFBAU - fontCheckSum);
+
+	return Assemble_Font(tables, checkSums);
+}
+
+// the font is opened like a user would, for be sure the benchmarks will run on a valid font
+static bool CheckFont(const StressParams& vParams)
+{
+	TTFRRW::TTFRRW ttfrrw;
+	if (!ttfrrw.OpenFontFile(vParams.outputFilePathName, TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS))
+	{
+		printf("check : failed to open %s\n", vParams.outputFilePathName.c_str());
+		return false;
+	}
+
+	bool res = true;
+	const auto infos = ttfrrw.GetFontInfos();
+	if (infos.m_GlyphCount != vParams.glyphCount)
+	{
+		printf("check : %u glyphs instead of %u\n", (uint32_t)infos.m_GlyphCount, vParams.glyphCount);
+		res = false;
+	}
+	const std::vector<TTFRRW::CodePoint> codePoints = GetCodePoints(vParams);
+	for (size_t idx = 0; idx < codePoints.size(); idx++)
+	{
+		const TTFRRW::GlyphIndex glyphIndex = ttfrrw.GetGlyphIndexFromCodePoint(codePoints[idx]);
+		if (glyphIndex != GetGlyphIndexOfCodePoint(vParams, idx))
+		{
+			printf("check : U+%04X mapped on glyph %u instead of %u\n",
+				codePoints[idx], (uint32_t)glyphIndex, (uint32_t)GetGlyphIndexOfCodePoint(vParams, idx));
+			res = false;
+			break;
+		}
+	}
+	const auto glyph = ttfrrw.GetGlyphWithGlyphIndex(1U);
+	if (!glyph || glyph->GetContoursCount() != vParams.contoursPerGlyph)
+	{
+		printf("check : the glyph 1 have not %u contours\n", vParams.contoursPerGlyph);
+		res = false;
+	}
+	else if (vParams.colrGlyphsCount && glyph->m_Layers.size() != vParams.layersPerGlyph)
+	{
+		printf("check : the glyph 1 have %u layers instead of %u\n", (uint32_t)glyph->m_Layers.size(), vParams.layersPerGlyph);
+		res = false;
+	}
+
+	return res;
+}
+
+///////////////////////////////////////////////////////////////////////
+//// MAIN /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	StressParams params;
+	bool codePointsCountSet = false;
+	for (int idx = 1; idx < argc; idx++)
+	{
+		const bool hasValue = (idx + 1 < argc);
+		if (!strcmp(argv[idx], "-o") && hasValue)
+			params.outputFilePathName = argv[++idx];
+		else if (!strcmp(argv[idx], "-glyphs") && hasValue)
+			params.glyphCount = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-points") && hasValue)
+			params.pointsPerGlyph = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-contours") && hasValue)
+			params.contoursPerGlyph = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-codepoints") && hasValue)
+		{
+			params.codePointsCount = (uint32_t)atoi(argv[++idx]);
+			codePointsCountSet = true;
+		}
+		else if (!strcmp(argv[idx], "-cmap-stride") && hasValue)
+			params.cmapStride = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-variations") && hasValue)
+			params.variationsCount = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-colr-glyphs") && hasValue)
+			params.colrGlyphsCount = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-layers") && hasValue)
+			params.layersPerGlyph = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-palettes") && hasValue)
+			params.palettesCount = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-palette-entries") && hasValue)
+			params.paletteEntriesCount = (uint32_t)atoi(argv[++idx]);
+		else if (!strcmp(argv[idx], "-seed") && hasValue)
+			params.seed = (uint32_t)atoi(argv[++idx]);
+		else
+		{
+			printf("unknown option %s, see the usage at the top of stressgen.cpp\n", argv[idx]);
+			return 1;
+		}
+	}
+	ClampParams(&params);
+	if (!codePointsCountSet) // one codepoint by glyph
+		params.codePointsCount = params.glyphCount - 1U;
+	params.codePointsCount = (uint32_t)GetCodePoints(params).size(); // limited by the unicode range
+
+	const TTFRRW::MemoryStream font = GenerateFont(params);
+	if (!WriteFile(params.outputFilePathName, font))
+	{
+		printf("failed to write %s\n", params.outputFilePathName.c_str());
+		return 1;
+	}
+	printf("%s : %u bytes, %u glyphs of %u points in %u contours, %u codepoints (stride %u), %u variations, %u color glyphs of %u layers, %u palettes of %u colors\n",
+		params.outputFilePathName.c_str(), (uint32_t)font.GetSize(), params.glyphCount, params.pointsPerGlyph, params.contoursPerGlyph,
+		params.codePointsCount, params.cmapStride, params.variationsCount, params.colrGlyphsCount, params.layersPerGlyph,
+		params.palettesCount, params.paletteEntriesCount);
+
+	if (!CheckFont(params))
+		return 1;
+	printf("check : ok\n");
+
+	return 0;
+}
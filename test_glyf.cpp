@@ -0,0 +1,224 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+// test of the decoders of the simple glyphs points, the simd decoder against the scalar reference decoder
+// usage : ttfrrw_test_glyf [font files...]
+// the fonts are testfont.ttf and testfont2_colr.ttf of the project if not given
+// the glyf and loca tables are read here, without TTFRRW, and each simple glyph is decoded :
+// - in place in the font file, like the parser do
+// - in a copy of the exact size of the glyph, so a read past the glyph is seen by the sanitizers
+// - in copies truncated of 1 and 2 bytes, the simd decoder must refuse them or give the same result
+// the flags, the coordinates and the end position of the two decoders must be the same
+// return 0 if all is ok, 1 else
+
+#include "ttfrrw.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef PROJECT_PATH
+#define PROJECT_PATH "."
+#endif
+
+///////////////////////////////////////////////////////////////////////
+//// FONT /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+static bool LoadFile(const std::string& vFilePathName, std::vector<uint8_t>* vDatas)
+{
+	bool res = false;
+	FILE* file = fopen(vFilePathName.c_str(), "rb");
+	if (file)
+	{
+		if (fseek(file, 0, SEEK_END) == 0)
+		{
+			const long size = ftell(file);
+			if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+			{
+				vDatas->resize((size_t)size);
+				res = (fread(vDatas->data(), 1U, vDatas->size(), file) == vDatas->size());
+			}
+		}
+		fclose(file);
+	}
+	return res;
+}
+
+static uint32_t GetUShort(const std::vector<uint8_t>& vDatas, const size_t& vPos)
+{
+	if (vPos + 2U > vDatas.size())
+		return 0U;
+	return ((uint32_t)vDatas[vPos] << 8) | (uint32_t)vDatas[vPos + 1U];
+}
+
+static uint32_t GetULong(const std::vector<uint8_t>& vDatas, const size_t& vPos)
+{
+	return (GetUShort(vDatas, vPos) << 16) | GetUShort(vDatas, vPos + 2U);
+}
+
+struct TableRecord
+{
+	size_t offset = 0U;
+	size_t length = 0U;
+};
+
+static bool GetTableRecord(const std::vector<uint8_t>& vDatas, const char* vTag, TableRecord* vRecord)
+{
+	const uint32_t tag = ((uint32_t)vTag[0] << 24) | ((uint32_t)vTag[1] << 16) | ((uint32_t)vTag[2] << 8) | (uint32_t)vTag[3];
+	const uint32_t numTables = GetUShort(vDatas, 4U);
+	for (uint32_t tableID = 0; tableID < numTables; tableID++)
+	{
+		const size_t pos = 12U + tableID * 16U;
+		if (GetULong(vDatas, pos) == tag)
+		{
+			vRecord->offset = GetULong(vDatas, pos + 8U);
+			vRecord->length = GetULong(vDatas, pos + 12U);
+			return (vRecord->offset + vRecord->length <= vDatas.size());
+		}
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////
+//// DECODERS /////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+struct DecodeStats
+{
+	size_t simpleGlyphs = 0U;
+	size_t points = 0U;
+	size_t simdDecodes = 0U; // accepted by the simd decoder
+	size_t scalarFallbacks = 0U; // refused by the simd decoder
+	size_t mismatches = 0U;
+};
+
+// decode the vCount points at vFlagsPos of vDatas with the two decoders, and compare them
+static bool CheckDecoders(const uint8_t* vDatas, const size_t& vSize, const size_t& vFlagsPos, const size_t& vCount, DecodeStats* vStats)
+{
+	std::vector<uint8_t> refFlags(vCount), flags(vCount);
+	std::vector<int16_t> refX(vCount), refY(vCount), x(vCount), y(vCount);
+
+	TTFRRW::MemoryStream mem;
+	mem.BorrowDatas(vDatas, vSize);
+
+	mem.SetPos(vFlagsPos);
+	TTFRRW::DecodeSimpleGlyfPoints_Scalar(&mem, vCount, refFlags.data(), refX.data(), refY.data());
+	const size_t refEnd = mem.GetPos();
+
+	mem.SetPos(vFlagsPos);
+	if (!TTFRRW::DecodeSimpleGlyfPoints_Simd(&mem, vCount, flags.data(), x.data(), y.data()))
+	{
+		vStats->scalarFallbacks++;
+		if (mem.GetPos() != vFlagsPos)
+		{
+			printf("  the simd decoder refused the points at %zu, but moved the stream to %zu\n", vFlagsPos, mem.GetPos());
+			return false;
+		}
+		return true;
+	}
+
+	vStats->simdDecodes++;
+	if (mem.GetPos() != refEnd ||
+		memcmp(refFlags.data(), flags.data(), vCount) != 0 ||
+		memcmp(refX.data(), x.data(), vCount * sizeof(int16_t)) != 0 ||
+		memcmp(refY.data(), y.data(), vCount * sizeof(int16_t)) != 0)
+	{
+		printf("  mismatch of the %zu points at %zu, end %zu for the scalar decoder and %zu for the simd decoder\n",
+			vCount, vFlagsPos, refEnd, mem.GetPos());
+		return false;
+	}
+	return true;
+}
+
+static bool TestFont(const std::string& vFilePathName)
+{
+	std::vector<uint8_t> datas;
+	if (!LoadFile(vFilePathName, &datas))
+	{
+		printf("%s : can't be read\n", vFilePathName.c_str());
+		return false;
+	}
+
+	TableRecord head, maxp, loca, glyf;
+	if (!GetTableRecord(datas, "head", &head) ||
+		!GetTableRecord(datas, "maxp", &maxp) ||
+		!GetTableRecord(datas, "loca", &loca) ||
+		!GetTableRecord(datas, "glyf", &glyf))
+	{
+		printf("%s : no head, maxp, loca or glyf table\n", vFilePathName.c_str());
+		return false;
+	}
+
+	const bool longLoca = (GetUShort(datas, head.offset + 50U) != 0U); // indexToLocFormat
+	const uint32_t numGlyphs = GetUShort(datas, maxp.offset + 4U);
+
+	DecodeStats stats;
+	for (uint32_t glyphID = 0; glyphID < numGlyphs; glyphID++)
+	{
+		const size_t start = glyf.offset + (longLoca ? GetULong(datas, loca.offset + glyphID * 4U) : GetUShort(datas, loca.offset + glyphID * 2U) * 2U);
+		const size_t end = glyf.offset + (longLoca ? GetULong(datas, loca.offset + glyphID * 4U + 4U) : GetUShort(datas, loca.offset + glyphID * 2U + 2U) * 2U);
+		if (end <= start + 10U || end > glyf.offset + glyf.length)
+			continue; // empty or broken glyph
+
+		const int16_t numberOfContours = (int16_t)GetUShort(datas, start);
+		if (numberOfContours <= 0)
+			continue; // composite glyph
+
+		const size_t endPtsPos = start + 10U;
+		const size_t pointsCount = GetUShort(datas, endPtsPos + (numberOfContours - 1U) * 2U) + 1U;
+		const size_t instructionsPos = endPtsPos + numberOfContours * 2U;
+		const size_t flagsPos = instructionsPos + 2U + GetUShort(datas, instructionsPos);
+		if (flagsPos >= end)
+			continue;
+
+		stats.simpleGlyphs++;
+		stats.points += pointsCount;
+
+		bool ok = CheckDecoders(datas.data(), datas.size(), flagsPos, pointsCount, &stats);
+
+		// heap copy of the exact size of the glyph, then truncated
+		for (size_t truncation = 0U; ok && truncation < 3U && flagsPos + truncation < end; truncation++)
+		{
+			const std::vector<uint8_t> glyphDatas(datas.begin() + start, datas.begin() + (end - truncation));
+			ok = CheckDecoders(glyphDatas.data(), glyphDatas.size(), flagsPos - start, pointsCount, &stats);
+		}
+
+		if (!ok)
+		{
+			printf("  glyph %u of %s\n", glyphID, vFilePathName.c_str());
+			stats.mismatches++;
+		}
+	}
+
+	printf("%s : %zu simple glyphs, %zu points, %zu simd decodes, %zu scalar fallbacks, %zu mismatches\n",
+		vFilePathName.c_str(), stats.simpleGlyphs, stats.points, stats.simdDecodes, stats.scalarFallbacks, stats.mismatches);
+
+	// a font without simd decode don't test anything
+	return (stats.mismatches == 0U && stats.simdDecodes > 0U);
+}
+
+///////////////////////////////////////////////////////////////////////
+//// MAIN /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> fonts;
+	for (int idx = 1; idx < argc; idx++)
+		fonts.push_back(argv[idx]);
+	if (fonts.empty())
+	{
+		fonts.push_back(std::string(PROJECT_PATH) + "/testfont.ttf");
+		fonts.push_back(std::string(PROJECT_PATH) + "/testfont2_colr.ttf");
+	}
+
+	bool res = true;
+	for (const auto& font : fonts)
+		res &= TestFont(font);
+
+	printf("%s\n", res ? "ok" : "failed");
+	return res ? 0 : 1;
+}
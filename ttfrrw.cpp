@@ -8,46 +8,620 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <cerrno>
+#include <cstring> // memcpy
+#include <algorithm> // sort, binary search
+
+#if defined(WIN32) || defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h> // file mapping
+#else
+#include <sys/mman.h> // mmap
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h> // byte swap with _mm256_shuffle_epi8
+#elif defined(__SSSE3__)
+#include <tmmintrin.h> // byte swap with _mm_shuffle_epi8
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SIMD_SSE2
+#include <emmintrin.h> // simple glyf decoder
+#endif
 
 #include <Tracy.hpp>
 
-#define VERBOSE_MODE
+// levels of the tracy zones, selected by TTFRRW_PROFILER_LEVEL (cmake option TTFRRW_PROFILER_LEVEL)
+// a level have its zones and the zones of the lower levels
+#define TTFRRW_PROFILER_LEVEL_API 1 // public methods, opening of fonts and collections
+#define TTFRRW_PROFILER_LEVEL_TABLE 2 // parsing and assembling of the tables, thread pool jobs
+#define TTFRRW_PROFILER_LEVEL_GLYPH 3 // glyphs and lookups
+#define TTFRRW_PROFILER_LEVEL_PRIMITIVE 4 // memory stream reads and writes, logs
+#ifndef TTFRRW_PROFILER_LEVEL
+#define TTFRRW_PROFILER_LEVEL TTFRRW_PROFILER_LEVEL_GLYPH
+#endif
+
+#ifdef TRACY_ENABLE
+// a zone per byte read cost more than the read, so the primitives are counted by thread
+// and the counts of a table zone are written in its text
+struct PrimitiveCounters
+{
+	uint64_t calls = 0U; // the zones of the primitive level
+	uint64_t readBytes = 0U;
+	uint64_t writtenBytes = 0U;
+};
+static thread_local PrimitiveCounters s_PrimitiveCounters;
+
+class PrimitiveCountersScope
+{
+private:
+	tracy::ScopedZone& m_Zone;
+	const PrimitiveCounters m_Start;
+
+public:
+	explicit PrimitiveCountersScope(tracy::ScopedZone& vZone) 
+		: m_Zone(vZone), m_Start(s_PrimitiveCounters) 
+	{
+	}
+	~PrimitiveCountersScope() // before the end of the zone
+	{
+		char buffer[128];
+		const int len = snprintf(buffer, sizeof(buffer), "primitives : %llu\nread : %llu bytes\nwritten : %llu bytes",
+			(unsigned long long)(s_PrimitiveCounters.calls - m_Start.calls),
+			(unsigned long long)(s_PrimitiveCounters.readBytes - m_Start.readBytes),
+			(unsigned long long)(s_PrimitiveCounters.writtenBytes - m_Start.writtenBytes));
+		if (len > 0)
+			m_Zone.Text(buffer, TTFRRW::mini((size_t)len, sizeof(buffer) - 1U));
+	}
+};
+#define TTFRRW_COUNT_PRIMITIVE s_PrimitiveCounters.calls++
+#define TTFRRW_COUNT_READ_BYTES(n) s_PrimitiveCounters.readBytes += (uint64_t)(n)
+#define TTFRRW_COUNT_WRITTEN_BYTES(n) s_PrimitiveCounters.writtenBytes += (uint64_t)(n)
+// the zone is named, the scope of ZoneScoped is an internal of tracy
+#define TTFRRW_ZONE_COUNTERS ZoneNamed(ttfrrw_zone, true); PrimitiveCountersScope ___ttfrrw_primitives(ttfrrw_zone)
+
+// the bytes read for a table, by the parser thread, or by the ranges if the table is parsed in parallel
+// since while its ranges are done, the parser thread help the other jobs
+// the plot name must be a literal, tracy keep the pointer
+class TableBytesPlot
+{
+private:
+	const char* m_Name;
+	const uint64_t m_Start;
+	std::atomic<uint64_t> m_RangesBytes;
+	std::atomic<bool> m_HaveRanges;
+
+public:
+	explicit TableBytesPlot(const char* vName)
+		: m_Name(vName), m_Start(s_PrimitiveCounters.readBytes), m_RangesBytes(0U), m_HaveRanges(false)
+	{
+	}
+	~TableBytesPlot()
+	{
+		const uint64_t bytes = m_HaveRanges.load() ? m_RangesBytes.load() : s_PrimitiveCounters.readBytes - m_Start;
+		TracyPlot(m_Name, (int64_t)bytes);
+	}
+	void AddRangeBytes(const uint64_t& vBytes)
+	{
+		m_RangesBytes += vBytes;
+		m_HaveRanges.store(true);
+	}
+};
+
+class TableRangeBytesScope
+{
+private:
+	TableBytesPlot& m_Plot;
+	const uint64_t m_Start;
+
+public:
+	explicit TableRangeBytesScope(TableBytesPlot& vPlot)
+		: m_Plot(vPlot), m_Start(s_PrimitiveCounters.readBytes)
+	{
+	}
+	~TableRangeBytesScope()
+	{
+		m_Plot.AddRangeBytes(s_PrimitiveCounters.readBytes - m_Start);
+	}
+};
+
+// the fonts opened at the same time are in the same frame, so a burst of loadings is one frame
+// the frames of a name can't overlap, so only the first start and the last end are marked
+struct FrameCounter
+{
+	const char* name;
+	size_t depth;
+};
+static std::mutex s_FramesMutex;
+static FrameCounter s_OpenFrame = { "TTFRRW Open", 0U };
+static FrameCounter s_WriteFrame = { "TTFRRW Write", 0U };
+
+class FrameScope
+{
+private:
+	FrameCounter& m_Frame;
+
+public:
+	explicit FrameScope(FrameCounter& vFrame)
+		: m_Frame(vFrame)
+	{
+		std::unique_lock<std::mutex> lock(s_FramesMutex);
+		if (m_Frame.depth++ == 0U)
+			FrameMarkStart(m_Frame.name);
+	}
+	~FrameScope()
+	{
+		std::unique_lock<std::mutex> lock(s_FramesMutex);
+		if (--m_Frame.depth == 0U)
+			FrameMarkEnd(m_Frame.name);
+	}
+};
+
+#define TTFRRW_PLOT(name, value) TracyPlot(name, (int64_t)(value))
+#define TTFRRW_PLOT_TABLE_BYTES(name) TableBytesPlot ___ttfrrw_table_bytes(name)
+#define TTFRRW_PLOT_TABLE_RANGE_BYTES TableRangeBytesScope ___ttfrrw_range_bytes(___ttfrrw_table_bytes)
+#define TTFRRW_FRAME_OPEN FrameScope ___ttfrrw_frame(s_OpenFrame)
+#define TTFRRW_FRAME_WRITE FrameScope ___ttfrrw_frame(s_WriteFrame)
+#else
+#define TTFRRW_COUNT_PRIMITIVE (void)0
+#define TTFRRW_COUNT_READ_BYTES(n) (void)0
+#define TTFRRW_COUNT_WRITTEN_BYTES(n) (void)0
+#define TTFRRW_ZONE_COUNTERS (void)0
+#define TTFRRW_PLOT(name, value) (void)0
+#define TTFRRW_PLOT_TABLE_BYTES(name) (void)0
+#define TTFRRW_PLOT_TABLE_RANGE_BYTES (void)0
+#define TTFRRW_FRAME_OPEN (void)0
+#define TTFRRW_FRAME_WRITE (void)0
+#endif
+
+#if TTFRRW_PROFILER_LEVEL >= TTFRRW_PROFILER_LEVEL_API
+#define TTFRRW_ZONE_API ZoneScoped
+#else
+#define TTFRRW_ZONE_API (void)0
+#endif
+
+#if TTFRRW_PROFILER_LEVEL >= TTFRRW_PROFILER_LEVEL_TABLE
+#define TTFRRW_ZONE_TABLE TTFRRW_ZONE_COUNTERS
+#else
+#define TTFRRW_ZONE_TABLE (void)0
+#endif
+
+#if TTFRRW_PROFILER_LEVEL >= TTFRRW_PROFILER_LEVEL_GLYPH
+#define TTFRRW_ZONE_GLYPH ZoneScoped
+#else
+#define TTFRRW_ZONE_GLYPH (void)0
+#endif
+
+#if TTFRRW_PROFILER_LEVEL >= TTFRRW_PROFILER_LEVEL_PRIMITIVE
+#define TTFRRW_ZONE_PRIMITIVE ZoneScoped; TTFRRW_COUNT_PRIMITIVE
+#else
+#define TTFRRW_ZONE_PRIMITIVE TTFRRW_COUNT_PRIMITIVE
+#endif
 
-// will use stl classe (std::vector) instead of simple c array
-//#define USE_STL_CLASSES
+// the info logs are compiled only with TTFRRW_INFO_LOGS (cmake option TTFRRW_ENABLE_INFO_LOGS)
+// else LogInfos is nothing, the arguments are not evaluated
+// the errors are always compiled, and filtered at runtime by TTFRRW_PROCESSING_FLAG_NO_ERRORS
 
 ///////////////////////////////////////////////////////////////////////
 //// LOGGING //////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 
+#ifdef TTFRRW_INFO_LOGS
 inline static void LogInfos(const TTFRRW::ttfrrwProcessingFlags& vFlags, const char* fmt, ...)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_PRIMITIVE;
 
-#ifdef VERBOSE_MODE
 	if (!(vFlags & TTFRRW::TTFRRW_PROCESSING_FLAG_VERBOSE_ONLY_ERRORS))
 	{
 		va_list args;
 		va_start(args, fmt);
-		vprintf(fmt, args);
+		if (!TTFRRW::LogSink::Instance()->Push(TTFRRW::LOG_LEVEL_INFOS, fmt, args))
+			vprintf(fmt, args);
 		va_end(args);
 	}
-#endif
 }
+#else
+#define LogInfos(...) ((void)0)
+#endif
 
 inline static void LogError(const TTFRRW::ttfrrwProcessingFlags& vFlags, const char* fmt, ...)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_PRIMITIVE;
 
-#ifdef VERBOSE_MODE
 	if (!(vFlags & TTFRRW::TTFRRW_PROCESSING_FLAG_NO_ERRORS))
 	{
 		va_list args;
 		va_start(args, fmt);
-		vprintf(fmt, args);
+		if (!TTFRRW::LogSink::Instance()->Push(TTFRRW::LOG_LEVEL_ERROR, fmt, args))
+			vprintf(fmt, args);
 		va_end(args);
 	}
+}
+
+///////////////////////////////////////////////////////////////////////
+//// LOG SINK /////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// a conversion of a printf format : %[flags][width][.precision][length]conversion
+struct LogFormatSpec
+{
+	enum Length { LENGTH_NONE = 0, LENGTH_HH, LENGTH_H, LENGTH_L, LENGTH_LL, LENGTH_J, LENGTH_Z, LENGTH_T };
+
+	const char* options = nullptr; // flags, width and precision, after the '%'
+	size_t optionsSize = 0U;
+	Length length = LENGTH_NONE;
+	char conversion = 0;
+	const char* end = nullptr; // after the conversion
+};
+
+// vPercent is on the '%' of a conversion, not of a "%%"
+// false if the conversion can't be deferred : %n, * widths, long double, wide strings, or unknown
+static bool ParseLogFormatSpec(const char* vPercent, LogFormatSpec* vOutSpec)
+{
+	const char* c = vPercent + 1;
+	vOutSpec->options = c;
+	while (*c && strchr("-+ #0", *c))
+		++c;
+	while (*c >= '0' && *c <= '9')
+		++c;
+	if (*c == '.')
+	{
+		++c;
+		while (*c >= '0' && *c <= '9')
+			++c;
+	}
+	vOutSpec->optionsSize = (size_t)(c - vOutSpec->options);
+
+	vOutSpec->length = LogFormatSpec::LENGTH_NONE;
+	if (c[0] == 'h' && c[1] == 'h') { vOutSpec->length = LogFormatSpec::LENGTH_HH; c += 2; }
+	else if (c[0] == 'h') { vOutSpec->length = LogFormatSpec::LENGTH_H; ++c; }
+	else if (c[0] == 'l' && c[1] == 'l') { vOutSpec->length = LogFormatSpec::LENGTH_LL; c += 2; }
+	else if (c[0] == 'l') { vOutSpec->length = LogFormatSpec::LENGTH_L; ++c; }
+	else if (c[0] == 'j') { vOutSpec->length = LogFormatSpec::LENGTH_J; ++c; }
+	else if (c[0] == 'z') { vOutSpec->length = LogFormatSpec::LENGTH_Z; ++c; }
+	else if (c[0] == 't') { vOutSpec->length = LogFormatSpec::LENGTH_T; ++c; }
+	else if (c[0] == 'L') return false;
+
+	vOutSpec->conversion = *c;
+	vOutSpec->end = c + 1;
+	if (!*c || !strchr("diouxXcfFeEgGaAsp", *c))
+		return false;
+	if (*c == 's' && vOutSpec->length != LogFormatSpec::LENGTH_NONE)
+		return false;
+	return true;
+}
+
+TTFRRW::LogSink* TTFRRW::LogSink::Instance()
+{
+	static LogSink _instance;
+	return &_instance;
+}
+
+TTFRRW::LogSink::LogSink()
+	: m_WritePos(0U), m_DroppedCount(0U), m_Producers(0U), m_Running(false), m_StopRequested(false)
+{
+
+}
+
+TTFRRW::LogSink::~LogSink()
+{
+	Stop();
+}
+
+bool TTFRRW::LogSink::StartWithCallback(const LogCallback& vCallback, const size_t& vCapacity)
+{
+	if (!vCallback)
+		return false;
+
+	std::unique_lock<std::mutex> lock(m_StartMutex);
+	StopWorker();
+	m_Callback = vCallback;
+	return StartWorker(vCapacity);
+}
+
+bool TTFRRW::LogSink::StartWithFile(const std::string& vFilePathName, const size_t& vCapacity)
+{
+	std::unique_lock<std::mutex> lock(m_StartMutex);
+	StopWorker();
+#if defined(MSVC)
+	if (fopen_s(&m_File, vFilePathName.c_str(), "w") != 0)
+		m_File = nullptr;
+#else
+	m_File = fopen(vFilePathName.c_str(), "w");
 #endif
+	if (!m_File)
+		return false;
+	return StartWorker(vCapacity);
+}
+
+bool TTFRRW::LogSink::StartWorker(const size_t& vCapacity)
+{
+	size_t capacity = 2U;
+	while (capacity < vCapacity)
+		capacity <<= 1U;
+
+	m_Records.reset(new Record[capacity]);
+	for (size_t idx = 0; idx < capacity; idx++)
+	{
+		m_Records[idx].sequence.store(idx, std::memory_order_relaxed);
+	}
+	m_Mask = capacity - 1U;
+	m_WritePos.store(0U);
+	m_ReadPos = 0U;
+	m_DroppedCount.store(0U);
+	m_StopRequested.store(false);
+	m_Worker = std::thread(&LogSink::WorkerLoop, this);
+	m_Running.store(true);
+
+	return true;
+}
+
+void TTFRRW::LogSink::Stop()
+{
+	std::unique_lock<std::mutex> lock(m_StartMutex);
+	StopWorker();
+}
+
+void TTFRRW::LogSink::StopWorker()
+{
+	// no more pushes, and the pushes in progress are finished before the last flush
+	m_Running.store(false);
+	while (m_Producers.load())
+	{
+		std::this_thread::yield();
+	}
+
+	if (m_Worker.joinable())
+	{
+		m_StopRequested.store(true);
+		m_Worker.join();
+	}
+
+	if (m_File)
+	{
+		fclose(m_File);
+		m_File = nullptr;
+	}
+	m_Callback = nullptr;
+	m_Records.reset();
+	m_Mask = 0U;
+}
+
+bool TTFRRW::LogSink::IsRunning() const
+{
+	return m_Running.load();
+}
+
+uint64_t TTFRRW::LogSink::GetDroppedCount() const
+{
+	return m_DroppedCount.load(std::memory_order_relaxed);
+}
+
+bool TTFRRW::LogSink::Push(const LogLevel& vLevel, const char* vFmt, va_list vArgs)
+{
+	if (!m_Running.load(std::memory_order_relaxed))
+		return false;
+
+	m_Producers.fetch_add(1U);
+	if (!m_Running.load())
+	{
+		m_Producers.fetch_sub(1U);
+		return false;
+	}
+
+	// bounded multi producers queue, each record have a sequence number
+	// the record is free for the position pos if its sequence is pos, and full if its sequence is pos + 1
+	Record* record = nullptr;
+	size_t pos = m_WritePos.load(std::memory_order_relaxed);
+	while (true)
+	{
+		record = &m_Records[pos & m_Mask];
+		const size_t sequence = record->sequence.load(std::memory_order_acquire);
+		const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+		if (diff == 0)
+		{
+			if (m_WritePos.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0) // full, never wait
+		{
+			m_DroppedCount.fetch_add(1U, std::memory_order_relaxed);
+			m_Producers.fetch_sub(1U);
+			return true;
+		}
+		else
+		{
+			pos = m_WritePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// the va_list can't be kept, so the arguments are read here in the record, by the conversions of the format
+	// only the strings are copied, the formating is done by the background thread
+	record->level = vLevel;
+	record->format = vFmt;
+	va_list args;
+	va_copy(args, vArgs); // for the formating here, if the format can't be deferred
+	size_t argsCount = 0U;
+	size_t textsSize = 0U;
+	for (const char* c = vFmt; *c && record->format; ++c)
+	{
+		if (*c != '%')
+			continue;
+		if (c[1] == '%')
+		{
+			++c;
+			continue;
+		}
+
+		LogFormatSpec spec;
+		if (!ParseLogFormatSpec(c, &spec) || argsCount >= MAX_ARGS)
+		{
+			record->format = nullptr;
+			break;
+		}
+		Arg& arg = record->args[argsCount++];
+
+		switch (spec.conversion)
+		{
+		case 'd':
+		case 'i':
+		case 'c':
+			switch (spec.length)
+			{
+			case LogFormatSpec::LENGTH_HH: arg.i = (signed char)va_arg(vArgs, int); break;
+			case LogFormatSpec::LENGTH_H: arg.i = (short)va_arg(vArgs, int); break;
+			case LogFormatSpec::LENGTH_L: arg.i = va_arg(vArgs, long); break;
+			case LogFormatSpec::LENGTH_LL: arg.i = va_arg(vArgs, long long); break;
+			case LogFormatSpec::LENGTH_J: arg.i = (long long)va_arg(vArgs, intmax_t); break;
+			case LogFormatSpec::LENGTH_Z: arg.i = (long long)va_arg(vArgs, size_t); break;
+			case LogFormatSpec::LENGTH_T: arg.i = (long long)va_arg(vArgs, ptrdiff_t); break;
+			default: arg.i = va_arg(vArgs, int); break;
+			}
+			break;
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			switch (spec.length)
+			{
+			case LogFormatSpec::LENGTH_HH: arg.u = (unsigned char)va_arg(vArgs, unsigned int); break;
+			case LogFormatSpec::LENGTH_H: arg.u = (unsigned short)va_arg(vArgs, unsigned int); break;
+			case LogFormatSpec::LENGTH_L: arg.u = va_arg(vArgs, unsigned long); break;
+			case LogFormatSpec::LENGTH_LL: arg.u = va_arg(vArgs, unsigned long long); break;
+			case LogFormatSpec::LENGTH_J: arg.u = (unsigned long long)va_arg(vArgs, uintmax_t); break;
+			case LogFormatSpec::LENGTH_Z: arg.u = (unsigned long long)va_arg(vArgs, size_t); break;
+			case LogFormatSpec::LENGTH_T: arg.u = (unsigned long long)va_arg(vArgs, ptrdiff_t); break;
+			default: arg.u = va_arg(vArgs, unsigned int); break;
+			}
+			break;
+		case 's':
+		{
+			// copied, truncated if the texts are full, the last byte stay the end of an empty string
+			const char* str = va_arg(vArgs, const char*);
+			arg.text = mini(textsSize, MESSAGE_SIZE - 1U);
+			const size_t len = str ? mini(strlen(str), MESSAGE_SIZE - 1U - arg.text) : 0U;
+			if (len)
+				memcpy(record->texts + arg.text, str, len);
+			record->texts[arg.text + len] = '\0';
+			textsSize = arg.text + len + 1U;
+			break;
+		}
+		case 'p':
+			arg.p = va_arg(vArgs, void*);
+			break;
+		default: // the floats
+			arg.d = va_arg(vArgs, double);
+			break;
+		}
+
+		c = spec.end - 1;
+	}
+	if (!record->format)
+		vsnprintf(record->texts, MESSAGE_SIZE, vFmt, args);
+	va_end(args);
+	record->sequence.store(pos + 1U, std::memory_order_release);
+
+	m_Producers.fetch_sub(1U);
+	return true;
+}
+
+// the message of a deferred record, formated one conversion at a time
+// the integers are given as long long, so the length is replaced by ll
+void TTFRRW::LogSink::FormatRecord(const Record& vRecord, char* vOutMessage)
+{
+	size_t pos = 0U;
+	size_t argIdx = 0U;
+	for (const char* c = vRecord.format; *c && pos + 1U < MESSAGE_SIZE; ++c)
+	{
+		if (*c != '%')
+		{
+			vOutMessage[pos++] = *c;
+			continue;
+		}
+		if (c[1] == '%')
+		{
+			vOutMessage[pos++] = '%';
+			++c;
+			continue;
+		}
+
+		LogFormatSpec spec;
+		if (!ParseLogFormatSpec(c, &spec) || argIdx >= MAX_ARGS)
+			break; // not possible, checked by Push
+		const Arg& arg = vRecord.args[argIdx++];
+
+		char conversion[32];
+		const bool isInteger = (strchr("diouxX", spec.conversion) != nullptr);
+		snprintf(conversion, sizeof(conversion), "%%%.*s%s%c", (int)spec.optionsSize, spec.options, isInteger ? "ll" : "", spec.conversion);
+
+		int written = 0;
+		switch (spec.conversion)
+		{
+		case 'd': case 'i': written = snprintf(vOutMessage + pos, MESSAGE_SIZE - pos, conversion, arg.i); break;
+		case 'o': case 'u': case 'x': case 'X': written = snprintf(vOutMessage + pos, MESSAGE_SIZE - pos, conversion, arg.u); break;
+		case 'c': written = snprintf(vOutMessage + pos, MESSAGE_SIZE - pos, conversion, (int)arg.i); break;
+		case 's': written = snprintf(vOutMessage + pos, MESSAGE_SIZE - pos, conversion, vRecord.texts + arg.text); break;
+		case 'p': written = snprintf(vOutMessage + pos, MESSAGE_SIZE - pos, conversion, arg.p); break;
+		default: written = snprintf(vOutMessage + pos, MESSAGE_SIZE - pos, conversion, arg.d); break;
+		}
+		if (written > 0)
+			pos = mini(pos + (size_t)written, MESSAGE_SIZE - 1U);
+
+		c = spec.end - 1;
+	}
+	vOutMessage[pos] = '\0';
+}
+
+size_t TTFRRW::LogSink::Flush()
+{
+	size_t count = 0U;
+	while (true)
+	{
+		Record& record = m_Records[m_ReadPos & m_Mask];
+		if (record.sequence.load(std::memory_order_acquire) != m_ReadPos + 1U)
+			break; // empty, or the record is not finished
+
+		char message[MESSAGE_SIZE];
+		if (record.format)
+			FormatRecord(record, message);
+		else
+			memcpy(message, record.texts, MESSAGE_SIZE);
+
+		if (m_Callback)
+			m_Callback(record.level, message);
+		if (m_File)
+			fputs(message, m_File);
+
+		// free for the next turn of the ring
+		record.sequence.store(m_ReadPos + m_Mask + 1U, std::memory_order_release);
+		m_ReadPos++;
+		count++;
+	}
+
+	if (count && m_File)
+		fflush(m_File);
+
+	return count;
+}
+
+void TTFRRW::LogSink::WorkerLoop()
+{
+	while (true)
+	{
+		if (!Flush())
+		{
+			if (m_StopRequested.load())
+			{
+				Flush(); // the last records pushed before the stop
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -94,6 +668,12 @@ size_t TTFRRW::cProfiler::result_Count()
 	return count;
 }
 
+void TTFRRW::cProfiler::merge(const cProfiler& vProfiler)
+{
+	value += vProfiler.value;
+	count += vProfiler.count;
+}
+
 void TTFRRW::cProfiler::print(ttfrrwProcessingFlags vFlags, const char* parent, const char* label)
 {
 	if (vFlags & TTFRRW_PROCESSING_FLAG_VERBOSE_PROFILER)
@@ -130,388 +710,1921 @@ void TTFRRW::cProfiler::erasePrint(ttfrrwProcessingFlags vFlags, const char* par
 
 #endif
 
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-
-TTFRRW::MemoryStream::MemoryStream()
+// histogram bucket of a time, 8 buckets per power of two
+static size_t GetTimingBucket(const uint64_t& vNanoSeconds)
 {
-	ZoneScoped;
+	if (vNanoSeconds < 8U)
+		return (size_t)vNanoSeconds;
+
+	size_t exponent = 3U;
+	while (exponent < 63U && (vNanoSeconds >> (exponent + 1U)))
+		exponent++;
+	const size_t sub = (size_t)((vNanoSeconds >> (exponent - 3U)) & 7U);
+	return TTFRRW::mini((exponent - 2U) * 8U + sub, TTFRRW::TimingRegistry::HISTOGRAM_SIZE - 1U);
 }
 
-TTFRRW::MemoryStream::MemoryStream(const uint8_t* vDatas, const size_t& vSize)
+// greatest time of a bucket
+static uint64_t GetTimingBucketMax(const size_t& vBucket)
 {
-	ZoneScoped;
+	if (vBucket < 8U)
+		return (uint64_t)vBucket;
 
-	SetDatas(vDatas, vSize);
+	const size_t exponent = vBucket / 8U + 2U;
+	const uint64_t sub = (uint64_t)(vBucket % 8U);
+	return ((9U + sub) << (exponent - 3U)) - 1U;
 }
 
-TTFRRW::MemoryStream::~MemoryStream()
+const size_t TTFRRW::TimingRegistry::ROOT_NODE;
+const size_t TTFRRW::TimingRegistry::HISTOGRAM_SIZE;
+
+void TTFRRW::TimingRegistry::Stats::Add(const uint64_t& vNanoSeconds)
 {
-	ZoneScoped;
-}
+	if (!count || vNanoSeconds < min)
+		min = vNanoSeconds;
+	if (!count || vNanoSeconds > max)
+		max = vNanoSeconds;
+	count++;
+	total += vNanoSeconds;
 
-////////////////////////////////////////////////////////////////
-//// WRITE /////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////
+	if (histogram.empty())
+		histogram.resize(HISTOGRAM_SIZE);
+	histogram[GetTimingBucket(vNanoSeconds)]++;
+}
 
-void TTFRRW::MemoryStream::AppendMemoryStream(const MemoryStream& vMem)
+void TTFRRW::TimingRegistry::Stats::Merge(const Stats& vStats)
 {
-	if (vMem.GetSize())
+	if (!vStats.count)
+		return;
+
+	if (!count)
+	{
+		*this = vStats;
+		return;
+	}
+
+	min = mini(min, vStats.min);
+	max = maxi(max, vStats.max);
+	count += vStats.count;
+	total += vStats.total;
+	for (size_t idx = 0; idx < vStats.histogram.size() && idx < histogram.size(); idx++)
 	{
-		WriteBytes(&vMem.m_Datas);
+		histogram[idx] += vStats.histogram[idx];
 	}
 }
 
-void TTFRRW::MemoryStream::WriteByte(const uint8_t& b)
+uint64_t TTFRRW::TimingRegistry::Stats::GetPercentile(const double& vPercent) const
 {
-	ZoneScoped;
+	if (!count)
+		return 0U;
 
-	m_Datas.push_back(b);
+	// the bucket of the value at the rank, kept in the real bounds
+	const uint64_t rank = maxi((uint64_t)std::ceil(vPercent * (double)count), (uint64_t)1U);
+	uint64_t countBelow = 0U;
+	for (size_t idx = 0; idx < histogram.size(); idx++)
+	{
+		countBelow += histogram[idx];
+		if (countBelow >= rank)
+			return maxi(mini(GetTimingBucketMax(idx), max), min);
+	}
+
+	return max;
 }
 
-void TTFRRW::MemoryStream::WriteBytes(const std::vector<uint8_t>* vDatas)
+TTFRRW::TimingRegistry::TimingRegistry()
 {
-	if (vDatas)
-	{
-		ZoneScoped;
+	m_Nodes.resize(1U); // root
+}
 
-		m_Datas.insert(m_Datas.end(), vDatas->begin(), vDatas->end());
-	}
+TTFRRW::TimingRegistry::TimingRegistry(const TimingRegistry& vRegistry)
+{
+	std::unique_lock<std::mutex> lock(vRegistry.m_Mutex);
+	m_Nodes = vRegistry.m_Nodes;
 }
 
-void TTFRRW::MemoryStream::WriteBytes(const uint8_t* vDatas, const size_t& vSize)
+TTFRRW::TimingRegistry& TTFRRW::TimingRegistry::operator = (const TimingRegistry& vRegistry)
 {
-	if (vDatas && vSize)
+	if (this != &vRegistry)
 	{
-		ZoneScoped;
-
-		std::vector<uint8_t> arr; 
-		arr.resize(vSize);
-		memcpy(arr.data(), vDatas, vSize);
-		m_Datas.insert(m_Datas.end(), arr.begin(), arr.end());
+		std::vector<Node> nodes;
+		{
+			std::unique_lock<std::mutex> lock(vRegistry.m_Mutex);
+			nodes = vRegistry.m_Nodes;
+		}
+		// the two mutexes are never locked together
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Nodes.swap(nodes);
 	}
+	return *this;
 }
 
-void TTFRRW::MemoryStream::WriteInt(const int32_t& i)
+size_t TTFRRW::TimingRegistry::GetNode(const size_t& vParentNode, const char* vName)
 {
-	ZoneScoped;
-
-	WriteByte((uint8_t)((i >> 24) & 0xff));
-	WriteByte((uint8_t)((i >> 16) & 0xff));
-	WriteByte((uint8_t)((i >> 8) & 0xff));
-	WriteByte((uint8_t)(i & 0xff));
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	return GetNodeLocked(vParentNode, vName);
 }
 
-void TTFRRW::MemoryStream::WriteUShort(const int32_t& us)
+void TTFRRW::TimingRegistry::Add(const size_t& vNode, const uint64_t& vNanoSeconds)
 {
-	ZoneScoped;
-
-	WriteByte((uint8_t)((us >> 8) & 0xff));
-	WriteByte((uint8_t)(us & 0xff));
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	if (vNode < m_Nodes.size())
+		m_Nodes[vNode].stats.Add(vNanoSeconds);
 }
 
-void TTFRRW::MemoryStream::WriteFWord(const int32_t& us)
+void TTFRRW::TimingRegistry::Add(const size_t& vNode, const Stats& vStats)
 {
-	ZoneScoped;
-
-	WriteUShort(us);
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	if (vNode < m_Nodes.size())
+		m_Nodes[vNode].stats.Merge(vStats);
 }
 
-void TTFRRW::MemoryStream::WriteUFWord(const int32_t& us)
+void TTFRRW::TimingRegistry::Merge(const TimingRegistry& vRegistry, const size_t& vParentNode)
 {
-	ZoneScoped;
+	if (&vRegistry == this)
+		return;
 
-	WriteFWord(us);
+	std::vector<Node> nodes;
+	{
+		std::unique_lock<std::mutex> lock(vRegistry.m_Mutex);
+		nodes = vRegistry.m_Nodes;
+	}
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	for (const auto& child : nodes[ROOT_NODE].children)
+	{
+		MergeNode(nodes, child, vParentNode);
+	}
 }
 
-void TTFRRW::MemoryStream::WriteShort(const int32_t& s)
+void TTFRRW::TimingRegistry::Reset()
 {
-	ZoneScoped;
-
-	WriteUShort(s);
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Nodes.clear();
+	m_Nodes.resize(1U); // root
 }
 
-void TTFRRW::MemoryStream::WriteUInt24(const int32_t& ui)
+std::vector<TTFRRW::TimingRegistry::Entry> TTFRRW::TimingRegistry::GetEntries() const
 {
-	ZoneScoped;
+	std::vector<Entry> res;
 
-	WriteByte((uint8_t)(ui >> 16) & 0xff);
-	WriteByte((uint8_t)(ui >> 8) & 0xff);
-	WriteByte((uint8_t)ui & 0xff);
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	for (const auto& child : m_Nodes[ROOT_NODE].children)
+	{
+		FillEntries(child, "", 0U, &res);
+	}
+
+	return res;
+}
+
+bool TTFRRW::TimingRegistry::GetEntry(const std::string& vPath, Entry* vOutEntry) const
+{
+	for (const auto& entry : GetEntries())
+	{
+		if (entry.path == vPath)
+		{
+			if (vOutEntry)
+				*vOutEntry = entry;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::string TTFRRW::TimingRegistry::GetJson() const
+{
+	std::string res = "{\"timings\":[";
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	const auto& children = m_Nodes[ROOT_NODE].children;
+	for (size_t idx = 0; idx < children.size(); idx++)
+	{
+		if (idx)
+			res += ",";
+		WriteJson(children[idx], &res);
+	}
+	res += "]}";
+
+	return res;
+}
+
+void TTFRRW::TimingRegistry::Print(ttfrrwProcessingFlags vFlags, const char* vLabel) const
+{
+	if (vFlags & TTFRRW_PROCESSING_FLAG_VERBOSE_PROFILER)
+	{
+		if (vLabel && vLabel[0])
+			printf("%s :\n", vLabel);
+		for (const auto& entry : GetEntries())
+		{
+			printf("%*s%s : Count (%llu) Sum (%.9fs) Min (%.9fs) Max (%.9fs) P99 (%.9fs)\n", 
+				(int)(entry.depth * 2U), "", entry.path.c_str(), (unsigned long long)entry.count, 
+				entry.total, entry.min, entry.max, entry.p99);
+		}
+	}
+}
+
+// m_Mutex must be locked
+size_t TTFRRW::TimingRegistry::GetNodeLocked(const size_t& vParentNode, const std::string& vName)
+{
+	const size_t parentNode = (vParentNode < m_Nodes.size()) ? vParentNode : ROOT_NODE;
+	for (const auto& child : m_Nodes[parentNode].children)
+	{
+		if (m_Nodes[child].name == vName)
+			return child;
+	}
+
+	const size_t node = m_Nodes.size();
+	m_Nodes.push_back(Node());
+	m_Nodes[node].name = vName;
+	m_Nodes[node].parent = parentNode;
+	m_Nodes[parentNode].children.push_back(node);
+	return node;
+}
+
+// m_Mutex must be locked
+void TTFRRW::TimingRegistry::MergeNode(const std::vector<Node>& vNodes, const size_t& vNode, const size_t& vParentNode)
+{
+	const size_t node = GetNodeLocked(vParentNode, vNodes[vNode].name);
+	m_Nodes[node].stats.Merge(vNodes[vNode].stats);
+	for (const auto& child : vNodes[vNode].children)
+	{
+		MergeNode(vNodes, child, node);
+	}
+}
+
+// m_Mutex must be locked
+void TTFRRW::TimingRegistry::FillEntries(const size_t& vNode, const std::string& vParentPath, const size_t& vDepth, std::vector<Entry>* vOutEntries) const
+{
+	const Node& node = m_Nodes[vNode];
+
+	Entry entry;
+	entry.path = vParentPath.empty() ? node.name : vParentPath + "/" + node.name;
+	entry.depth = vDepth;
+	entry.count = node.stats.count;
+	entry.total = (double)node.stats.total * 1e-9;
+	entry.min = (double)node.stats.min * 1e-9;
+	entry.max = (double)node.stats.max * 1e-9;
+	entry.p99 = (double)node.stats.GetPercentile(0.99) * 1e-9;
+	vOutEntries->push_back(entry);
+
+	for (const auto& child : node.children)
+	{
+		FillEntries(child, entry.path, vDepth + 1U, vOutEntries);
+	}
+}
+
+// m_Mutex must be locked
+void TTFRRW::TimingRegistry::WriteJson(const size_t& vNode, std::string* vOutJson) const
+{
+	const Node& node = m_Nodes[vNode];
+
+	*vOutJson += "{\"name\":\"";
+	for (const auto& c : node.name)
+	{
+		if (c == '"' || c == '\\')
+			*vOutJson += '\\';
+		*vOutJson += c;
+	}
+
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "\",\"count\":%llu,\"total\":%.9f,\"min\":%.9f,\"max\":%.9f,\"p99\":%.9f,\"children\":[",
+		(unsigned long long)node.stats.count, (double)node.stats.total * 1e-9, (double)node.stats.min * 1e-9, 
+		(double)node.stats.max * 1e-9, (double)node.stats.GetPercentile(0.99) * 1e-9);
+	*vOutJson += buffer;
+
+	for (size_t idx = 0; idx < node.children.size(); idx++)
+	{
+		if (idx)
+			*vOutJson += ",";
+		WriteJson(node.children[idx], vOutJson);
+	}
+	*vOutJson += "]}";
+}
+
+TTFRRW::TimingScope::TimingScope(TimingRegistry* vRegistry, const size_t& vParentNode, const char* vName)
+{
+#ifdef USE_SIMPLE_PROFILER
+	if (vRegistry && vName)
+	{
+		m_Registry = vRegistry;
+		m_Node = vRegistry->GetNode(vParentNode, vName);
+		m_Start = std::chrono::steady_clock::now();
+	}
+#else
+	(void)vRegistry;
+	(void)vParentNode;
+	(void)vName;
+#endif
+}
+
+TTFRRW::TimingScope::TimingScope(TimingRegistry* vRegistry, const size_t& vNode)
+{
+#ifdef USE_SIMPLE_PROFILER
+	if (vRegistry)
+	{
+		m_Registry = vRegistry;
+		m_Node = vNode;
+		m_Start = std::chrono::steady_clock::now();
+	}
+#else
+	(void)vRegistry;
+	(void)vNode;
+#endif
+}
+
+TTFRRW::TimingScope::TimingScope(TimingRegistry::Stats* vStats)
+{
+#ifdef USE_SIMPLE_PROFILER
+	if (vStats)
+	{
+		m_Stats = vStats;
+		m_Start = std::chrono::steady_clock::now();
+	}
+#else
+	(void)vStats;
+#endif
+}
+
+TTFRRW::TimingScope::~TimingScope()
+{
+	Stop();
+}
+
+void TTFRRW::TimingScope::Stop()
+{
+	if (m_Registry || m_Stats)
+	{
+		const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start);
+		if (m_Registry)
+			m_Registry->Add(m_Node, (uint64_t)elapsed.count());
+		else
+			m_Stats->Add((uint64_t)elapsed.count());
+		m_Registry = nullptr;
+		m_Stats = nullptr;
+	}
+}
+
+size_t TTFRRW::TimingScope::GetNode() const
+{
+	return m_Node;
+}
+
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+TTFRRW::MemoryStream::MemoryStream()
+{
+	TTFRRW_ZONE_PRIMITIVE;
+}
+
+TTFRRW::MemoryStream::MemoryStream(const uint8_t* vDatas, const size_t& vSize)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	SetDatas(vDatas, vSize);
+}
+
+TTFRRW::MemoryStream::MemoryStream(const AllocatorHooks& vHooks)
+	: m_Datas(HookAllocator<uint8_t>(vHooks))
+{
+	TTFRRW_ZONE_PRIMITIVE;
+}
+
+TTFRRW::MemoryStream::MemoryStream(const MemoryStream& vMem)
+	: m_Datas(vMem.m_Datas.get_allocator())
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	*this = vMem;
+}
+
+TTFRRW::MemoryStream::MemoryStream(MemoryStream&& vMem)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	*this = std::move(vMem);
+}
+
+TTFRRW::MemoryStream& TTFRRW::MemoryStream::operator = (const MemoryStream& vMem)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	if (this != &vMem)
+	{
+		Release();
+
+		if (vMem.m_IsMapped) // a mapping can't be shared, so we copy it
+		{
+			SetDatas(vMem.GetDatas(), vMem.GetSize());
+		}
+		else
+		{
+			m_Datas = vMem.m_Datas;
+			m_ExternalDatas = vMem.m_ExternalDatas;
+			m_ExternalSize = vMem.m_ExternalSize;
+		}
+
+		m_ReadPos = vMem.m_ReadPos;
+	}
+
+	return *this;
+}
+
+TTFRRW::MemoryStream& TTFRRW::MemoryStream::operator = (MemoryStream&& vMem)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	if (this != &vMem)
+	{
+		Release();
+
+		m_Datas = std::move(vMem.m_Datas);
+		m_ExternalDatas = vMem.m_ExternalDatas;
+		m_ExternalSize = vMem.m_ExternalSize;
+		m_IsMapped = vMem.m_IsMapped;
+		m_MapHandle = vMem.m_MapHandle;
+		m_ReadPos = vMem.m_ReadPos;
+
+		vMem.m_ExternalDatas = nullptr;
+		vMem.m_ExternalSize = 0;
+		vMem.m_IsMapped = false;
+		vMem.m_MapHandle = nullptr;
+		vMem.m_ReadPos = 0;
+	}
+
+	return *this;
+}
+
+TTFRRW::MemoryStream::~MemoryStream()
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	Release();
+}
+
+////////////////////////////////////////////////////////////////
+//// MAPPING / BORROWING ///////////////////////////////////////
+////////////////////////////////////////////////////////////////
+
+bool TTFRRW::MemoryStream::MapFile(const std::string& vFilePathName, int* vError)
+{
+	TTFRRW_ZONE_API;
+
+	Release();
+
+	bool res = false;
+	int error = 0; // of the failed call, read before the closes who can change it
+
+#if defined(WIN32) || defined(_WIN32)
+	HANDLE file = CreateFileA(vFilePathName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			error = (int)GetLastError();
+		}
+		else if (fileSize.QuadPart <= 0)
+		{
+			error = ERROR_FILE_INVALID; // an empty file can't be mapped, like CreateFileMapping say
+		}
+		else
+		{
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping)
+			{
+				void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				if (ptr)
+				{
+					m_ExternalDatas = (const uint8_t*)ptr;
+					m_ExternalSize = (size_t)fileSize.QuadPart;
+					m_MapHandle = mapping;
+					m_IsMapped = true;
+					res = true;
+				}
+				else
+				{
+					error = (int)GetLastError();
+					CloseHandle(mapping);
+				}
+			}
+			else
+			{
+				error = (int)GetLastError();
+			}
+		}
+		CloseHandle(file); // the mapping keep its own reference on the file
+	}
+	else
+	{
+		error = (int)GetLastError();
+	}
+#else
+	const int fd = open(vFilePathName.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			error = errno;
+		}
+		else if (!S_ISREG(st.st_mode) || st.st_size <= 0)
+		{
+			error = EINVAL; // not a regular file, or empty, like mmap say
+		}
+		else
+		{
+			void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (ptr != MAP_FAILED)
+			{
+				m_ExternalDatas = (const uint8_t*)ptr;
+				m_ExternalSize = (size_t)st.st_size;
+				m_IsMapped = true;
+				res = true;
+			}
+			else
+			{
+				error = errno;
+			}
+		}
+		close(fd); // the mapping keep its own reference on the file
+	}
+	else
+	{
+		error = errno;
+	}
+#endif
+
+	if (!res && vError)
+		*vError = error;
+
+	return res;
+}
+
+void TTFRRW::MemoryStream::BorrowDatas(const uint8_t* vDatas, const size_t& vSize)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	Release();
+
+	if (vDatas && vSize)
+	{
+		m_ExternalDatas = vDatas;
+		m_ExternalSize = vSize;
+	}
+}
+
+void TTFRRW::MemoryStream::Advise(const size_t& vOffset, const size_t& vLen, const AccessHint& vHint)
+{
+	TTFRRW_ZONE_TABLE;
+
+#if defined(WIN32) || defined(_WIN32)
+	(void)vOffset;
+	(void)vLen;
+	(void)vHint;
+#else
+	if (m_IsMapped && vLen && vOffset < m_ExternalSize)
+	{
+		// madvise want a page aligned address
+		const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		const size_t start = vOffset - vOffset % pageSize;
+		const size_t end = mini(vOffset + vLen, m_ExternalSize);
+
+		int advice = MADV_NORMAL;
+		if (vHint == ACCESS_HINT_SEQUENTIAL) advice = MADV_SEQUENTIAL;
+		else if (vHint == ACCESS_HINT_RANDOM) advice = MADV_RANDOM;
+		else if (vHint == ACCESS_HINT_WILLNEED) advice = MADV_WILLNEED;
+
+		madvise((void*)(m_ExternalDatas + start), end - start, advice);
+	}
+#endif
+}
+
+bool TTFRRW::MemoryStream::IsOwner() const
+{
+	return (m_ExternalDatas == nullptr);
+}
+
+void TTFRRW::MemoryStream::Release()
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	if (m_IsMapped && m_ExternalDatas)
+	{
+#if defined(WIN32) || defined(_WIN32)
+		UnmapViewOfFile(m_ExternalDatas);
+		if (m_MapHandle)
+			CloseHandle((HANDLE)m_MapHandle);
+#else
+		munmap((void*)m_ExternalDatas, m_ExternalSize);
+#endif
+	}
+
+	m_Datas.clear();
+	m_ExternalDatas = nullptr;
+	m_ExternalSize = 0;
+	m_IsMapped = false;
+	m_MapHandle = nullptr;
+	m_ReadPos = 0;
+}
+
+void TTFRRW::MemoryStream::MakeOwner()
+{
+	if (m_ExternalDatas)
+	{
+		TTFRRW_ZONE_PRIMITIVE;
+
+		Datas datas(m_ExternalDatas, m_ExternalDatas + m_ExternalSize, m_Datas.get_allocator());
+		const size_t pos = m_ReadPos;
+		Release();
+		m_Datas = std::move(datas);
+		m_ReadPos = pos;
+	}
+}
+
+////////////////////////////////////////////////////////////////
+//// WRITE /////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////
+
+void TTFRRW::MemoryStream::AppendMemoryStream(const MemoryStream& vMem)
+{
+	if (vMem.GetSize())
+	{
+		WriteBytes(vMem.GetDatas(), vMem.GetSize());
+	}
+}
+
+void TTFRRW::MemoryStream::WriteByte(const uint8_t& b)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	MakeOwner();
+	m_Datas.push_back(b);
+	TTFRRW_COUNT_WRITTEN_BYTES(1U);
+}
+
+void TTFRRW::MemoryStream::WriteBytes(const std::vector<uint8_t>* vDatas)
+{
+	if (vDatas)
+	{
+		TTFRRW_ZONE_PRIMITIVE;
+
+		MakeOwner();
+		m_Datas.insert(m_Datas.end(), vDatas->begin(), vDatas->end());
+		TTFRRW_COUNT_WRITTEN_BYTES(vDatas->size());
+	}
+}
+
+void TTFRRW::MemoryStream::WriteBytes(const uint8_t* vDatas, const size_t& vSize)
+{
+	if (vDatas && vSize)
+	{
+		TTFRRW_ZONE_PRIMITIVE;
+
+		MakeOwner();
+		m_Datas.insert(m_Datas.end(), vDatas, vDatas + vSize);
+		TTFRRW_COUNT_WRITTEN_BYTES(vSize);
+	}
+}
+
+void TTFRRW::MemoryStream::WriteInt(const int32_t& i)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteByte((uint8_t)((i >> 24) & 0xff));
+	WriteByte((uint8_t)((i >> 16) & 0xff));
+	WriteByte((uint8_t)((i >> 8) & 0xff));
+	WriteByte((uint8_t)(i & 0xff));
+}
+
+void TTFRRW::MemoryStream::WriteUShort(const int32_t& us)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteByte((uint8_t)((us >> 8) & 0xff));
+	WriteByte((uint8_t)(us & 0xff));
+}
+
+void TTFRRW::MemoryStream::WriteFWord(const int32_t& us)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteUShort(us);
+}
+
+void TTFRRW::MemoryStream::WriteUFWord(const int32_t& us)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteFWord(us);
+}
+
+void TTFRRW::MemoryStream::WriteShort(const int32_t& s)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteUShort(s);
+}
+
+void TTFRRW::MemoryStream::WriteUInt24(const int32_t& ui)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteByte((uint8_t)(ui >> 16) & 0xff);
+	WriteByte((uint8_t)(ui >> 8) & 0xff);
+	WriteByte((uint8_t)ui & 0xff);
 }
 
 void TTFRRW::MemoryStream::WriteULong(const int64_t& ul)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteByte((uint8_t)((ul >> 24) & 0xff));
+	WriteByte((uint8_t)((ul >> 16) & 0xff));
+	WriteByte((uint8_t)((ul >> 8) & 0xff));
+	WriteByte((uint8_t)(ul & 0xff));
+}
+
+void TTFRRW::MemoryStream::WriteLong(const int64_t& l)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteULong(l);
+}
+
+void TTFRRW::MemoryStream::WriteFixed(const MemoryStream::Fixed& f)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteByte((uint8_t)((f.high >> 8) & 0xff));
+	WriteByte((uint8_t)(f.high & 0xff));
+	WriteByte((uint8_t)((f.low >> 8) & 0xff));
+	WriteByte((uint8_t)(f.low & 0xff));
+}
+
+void TTFRRW::MemoryStream::WriteF2DOT14(const MemoryStream::F2DOT14& f)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteShort(f.value);
+}
+
+void TTFRRW::MemoryStream::WriteDateTime(const longDateTime& date)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	WriteULong((date >> 32) & 0xffffffff); //-V112
+	WriteULong(date & 0xffffffff); //-V112
+}
+
+const uint32_t TTFRRW::MemoryStream::GetTag(const uint8_t& a, const uint8_t& b, const uint8_t& c, const uint8_t& d)
+{
+	return (d) | (c << 8) | (b << 16) | (a << 24);
+}
+
+void TTFRRW::MemoryStream::WriteTag(const std::string& vTag)
+{
+	if (vTag.size() >= 4) // only the 4 frist char will be used btw
+	{
+		WriteULong(GetTag(vTag[0], vTag[1], vTag[2], vTag[3]));
+	}
+}
+
+void TTFRRW::MemoryStream::WriteString(const std::string& vString)
+{
+	for (const auto& s : vString)
+	{
+		WriteByte(s);
+	}
+}
+
+const uint8_t* TTFRRW::MemoryStream::GetDatas() const
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	if (m_ExternalDatas)
+		return m_ExternalDatas;
+	return m_Datas.data();
+}
+
+const size_t TTFRRW::MemoryStream::GetSize() const
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	if (m_ExternalDatas)
+		return m_ExternalSize;
+	return m_Datas.size();
+}
+
+const size_t TTFRRW::MemoryStream::GetPos() const
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return m_ReadPos;
+}
+
+void TTFRRW::MemoryStream::SetPos(const size_t& vPos)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	m_ReadPos = vPos;
+}
+
+void TTFRRW::MemoryStream::SetDatas(const uint8_t* vDatas, const size_t& vSize)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	if (vDatas && vSize)
+	{
+		Release();
+
+		m_Datas.resize(vSize);
+
+		memcpy(m_Datas.data(), vDatas, vSize);
+	}
+}
+
+uint8_t* TTFRRW::MemoryStream::ResizeDatas(const size_t& vSize)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	MakeOwner();
+
+	m_Datas.resize(vSize);
+
+	return m_Datas.data();
+}
+
+////////////////////////////////////////////////////////////////
+//// READ //////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////
+
+const uint8_t TTFRRW::MemoryStream::ReadByte(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	if (vOffset + m_ReadPos < GetSize())
+	{
+		TTFRRW_COUNT_READ_BYTES(1U);
+		return GetDatas()[vOffset + m_ReadPos++];
+	}
+
+	return 0;
+}
+
+const std::vector<uint8_t> TTFRRW::MemoryStream::ReadBytes(const size_t& vLen, const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	std::vector<uint8_t> res;
+
+	if (vOffset + m_ReadPos + vLen < GetSize())
+	{
+		const uint8_t* start = GetDatas() + vOffset + m_ReadPos;
+		const uint8_t* end = start + vLen;
+		res = std::vector<uint8_t>(start, end);
+		m_ReadPos += vLen;
+		TTFRRW_COUNT_READ_BYTES(vLen);
+	}
+
+	return res;
+
+}
+
+const int32_t TTFRRW::MemoryStream::ReadUShort(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return 0xffff & (ReadByte(vOffset) << 8 | ReadByte(vOffset));
+}
+
+const int32_t TTFRRW::MemoryStream::ReadShort(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return ((ReadByte(vOffset) << 8 | ReadByte(vOffset)) << 16) >> 16;
+}
+
+const TTFRRW::MemoryStream::FWord TTFRRW::MemoryStream::ReadFWord(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return (int16_t)ReadShort(vOffset);
+}
+
+const TTFRRW::MemoryStream::UFWord TTFRRW::MemoryStream::ReadUFWord(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return (uint16_t)ReadUShort(vOffset);
+}
+
+const uint32_t TTFRRW::MemoryStream::ReadUInt24(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return 0xffffff & (ReadByte(vOffset) << 16 | ReadByte(vOffset) << 8 | ReadByte(vOffset));
+}
+
+const uint64_t TTFRRW::MemoryStream::ReadULong(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return 0xffffffffL & ReadLong(vOffset); //-V112
+}
+
+const uint32_t TTFRRW::MemoryStream::ReadULongAsInt(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	const int64_t ulong = ReadULong(vOffset);
+	return ((int32_t)ulong) & ~0x80000000; //-V112
+}
+
+const int32_t TTFRRW::MemoryStream::ReadLong(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return
+		ReadByte(vOffset) << 24 |
+		ReadByte(vOffset) << 16 |
+		ReadByte(vOffset) << 8 |
+		ReadByte(vOffset);
+}
+
+const TTFRRW::MemoryStream::Fixed TTFRRW::MemoryStream::ReadFixed(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	Fixed res;
+	const int32_t f = ReadLong(vOffset);
+	res.high = (int16_t)((f >> 16) & 0xff);
+	res.low = (int16_t)(f & 0xff);
+	return res;
+}
+
+const TTFRRW::MemoryStream::F2DOT14 TTFRRW::MemoryStream::ReadF2DOT14(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	F2DOT14 res;
+	res.value = (int16_t)ReadShort(vOffset);
+	return res;
+}
+
+const TTFRRW::MemoryStream::longDateTime TTFRRW::MemoryStream::ReadDateTime(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	return (int64_t)ReadULong(vOffset) << 32 | ReadULong(vOffset); //-V112
+}
+
+const std::string TTFRRW::MemoryStream::ReadString(const size_t& vLen, const size_t& vOffset)
+{
+	if (vOffset + m_ReadPos + vLen < GetSize())
+	{
+		TTFRRW_ZONE_PRIMITIVE;
+
+		const std::string res = std::string((const char*)(GetDatas() + vOffset + m_ReadPos), vLen);
+		m_ReadPos += vLen;
+		TTFRRW_COUNT_READ_BYTES(vLen);
+		return res;
+	}
+	return "";
+}
+
+const std::string TTFRRW::MemoryStream::ReadTag(const size_t& vOffset)
+{
+	TTFRRW_ZONE_PRIMITIVE;
+
+	std::string res = "OOOO"; // 4
+	uint32_t _tag = (uint32_t)ReadULong(vOffset);
+	res[0] = (uint8_t)((_tag >> 24) & 0xff);
+	res[1] = (uint8_t)((_tag >> 16) & 0xff);
+	res[2] = (uint8_t)((_tag >> 8) & 0xff);
+	res[3] = (uint8_t)(_tag & 0xff);
+	return res;
+}
+
+////////////////////////////////////////////////////////////////
+//// READ ARRAYS ///////////////////////////////////////////////
+////////////////////////////////////////////////////////////////
+
+// big endian => native byte swap of vCount values of 16 bits
+// vSrc have no alignment requirement
+static void SwapBytes16(const uint8_t* vSrc, uint16_t* vDst, const size_t& vCount)
+{
+	size_t idx = 0;
+#if defined(__AVX2__)
+	const __m256i mask = _mm256_setr_epi8(
+		1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+		1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	for (; idx + 16U <= vCount; idx += 16U)
+	{
+		const __m256i v = _mm256_loadu_si256((const __m256i*)(vSrc + idx * 2U));
+		_mm256_storeu_si256((__m256i*)(vDst + idx), _mm256_shuffle_epi8(v, mask));
+	}
+#endif
+#if defined(__AVX2__) || defined(__SSSE3__)
+	const __m128i mask128 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	for (; idx + 8U <= vCount; idx += 8U)
+	{
+		const __m128i v = _mm_loadu_si128((const __m128i*)(vSrc + idx * 2U));
+		_mm_storeu_si128((__m128i*)(vDst + idx), _mm_shuffle_epi8(v, mask128));
+	}
+#endif
+	for (; idx < vCount; idx++)
+	{
+		vDst[idx] = (uint16_t)((vSrc[idx * 2U] << 8) | vSrc[idx * 2U + 1U]);
+	}
+}
+
+// big endian => native byte swap of vCount values of 32 bits
+// vSrc have no alignment requirement
+static void SwapBytes32(const uint8_t* vSrc, uint32_t* vDst, const size_t& vCount)
+{
+	size_t idx = 0;
+#if defined(__AVX2__)
+	const __m256i mask = _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	for (; idx + 8U <= vCount; idx += 8U)
+	{
+		const __m256i v = _mm256_loadu_si256((const __m256i*)(vSrc + idx * 4U));
+		_mm256_storeu_si256((__m256i*)(vDst + idx), _mm256_shuffle_epi8(v, mask));
+	}
+#endif
+#if defined(__AVX2__) || defined(__SSSE3__)
+	const __m128i mask128 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	for (; idx + 4U <= vCount; idx += 4U)
+	{
+		const __m128i v = _mm_loadu_si128((const __m128i*)(vSrc + idx * 4U));
+		_mm_storeu_si128((__m128i*)(vDst + idx), _mm_shuffle_epi8(v, mask128));
+	}
+#endif
+	for (; idx < vCount; idx++)
+	{
+		const uint8_t* p = vSrc + idx * 4U;
+		vDst[idx] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+	}
+}
+
+bool TTFRRW::MemoryStream::ReadUShortArray(uint16_t* vDst, const size_t& vCount, const size_t& vOffset)
+{
+	if (!vDst || !vCount)
+		return true;
+
+	TTFRRW_ZONE_PRIMITIVE;
+
+	const size_t start = vOffset + m_ReadPos;
+	const size_t size = GetSize();
+	const size_t available = (start < size) ? (size - start) / 2U : 0U;
+	const size_t count = mini(vCount, available);
+
+	SwapBytes16(GetDatas() + start, vDst, count);
+	m_ReadPos += count * 2U;
+	TTFRRW_COUNT_READ_BYTES(count * 2U);
+
+	// out of the stream, same result as ReadUShort
+	for (size_t idx = count; idx < vCount; idx++)
+	{
+		vDst[idx] = (uint16_t)ReadUShort(vOffset);
+	}
+
+	return (count == vCount);
+}
+
+bool TTFRRW::MemoryStream::ReadShortArray(int16_t* vDst, const size_t& vCount, const size_t& vOffset)
+{
+	// same bits, only the interpretation change
+	return ReadUShortArray((uint16_t*)vDst, vCount, vOffset);
+}
+
+bool TTFRRW::MemoryStream::ReadULongArray(uint32_t* vDst, const size_t& vCount, const size_t& vOffset)
+{
+	if (!vDst || !vCount)
+		return true;
+
+	TTFRRW_ZONE_PRIMITIVE;
+
+	const size_t start = vOffset + m_ReadPos;
+	const size_t size = GetSize();
+	const size_t available = (start < size) ? (size - start) / 4U : 0U; //-V112
+	const size_t count = mini(vCount, available);
+
+	SwapBytes32(GetDatas() + start, vDst, count);
+	m_ReadPos += count * 4U; //-V112
+	TTFRRW_COUNT_READ_BYTES(count * 4U); //-V112
+
+	// out of the stream, same result as ReadULong
+	for (size_t idx = count; idx < vCount; idx++)
+	{
+		vDst[idx] = (uint32_t)ReadULong(vOffset);
+	}
+
+	return (count == vCount);
+}
+
+///////////////////////////////////////////////////////////////////////
+//// OUTLINE STORE ////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+TTFRRW::OutlineStore::OutlineStore(const AllocatorHooks& vHooks)
+	: m_X(HookAllocator<int16_t>(vHooks)), // the others share its hooks
+	m_Y(m_X.get_allocator()),
+	m_OnCurve(m_X.get_allocator()),
+	m_ContourEnds(m_X.get_allocator())
+{
+
+}
+
+void TTFRRW::OutlineStore::Clear()
+{
+	m_X.clear();
+	m_Y.clear();
+	m_OnCurve.clear();
+	m_ContourEnds.clear();
+}
+
+void TTFRRW::OutlineStore::Resize(const size_t& vPointsCount, const size_t& vContoursCount)
+{
+	m_X.resize(vPointsCount);
+	m_Y.resize(vPointsCount);
+	m_OnCurve.resize(vPointsCount);
+	m_ContourEnds.resize(vContoursCount);
+}
+
+size_t TTFRRW::OutlineStore::GetMemorySize() const
+{
+	return m_X.capacity() * sizeof(int16_t) +
+		m_Y.capacity() * sizeof(int16_t) +
+		m_OnCurve.capacity() * sizeof(uint8_t) +
+		m_ContourEnds.capacity() * sizeof(uint32_t);
+}
+
+///////////////////////////////////////////////////////////////////////
+//// CMAP /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+TTFRRW::CodePointTable::CodePointTable()
+{
+	memset(m_Latin1, 0, sizeof(m_Latin1));
+}
+
+TTFRRW::CodePointTable::CodePointTable(const AllocatorHooks& vHooks)
+	: m_Pages(HookAllocator<GlyphIndex>(vHooks)), // the others share its hooks
+	m_Directory(m_Pages.get_allocator()),
+	m_Ranges(m_Pages.get_allocator())
+{
+	memset(m_Latin1, 0, sizeof(m_Latin1));
+}
+
+void TTFRRW::CodePointTable::Clear()
+{
+	memset(m_Latin1, 0, sizeof(m_Latin1));
+	m_Pages.clear();
+	m_Directory.clear();
+	m_Ranges.clear();
+}
+
+void TTFRRW::CodePointTable::Set(const CodePoint& vCodePoint, const GlyphIndex& vGlyphIndex)
+{
+	if (vCodePoint < 256U)
+	{
+		m_Latin1[vCodePoint] = vGlyphIndex;
+		return;
+	}
+
+	if (vCodePoint > MAX_CODEPOINT)
+		return;
+
+	const size_t page = (size_t)(vCodePoint >> 8);
+	if (page >= m_Directory.size())
+	{
+		if (!vGlyphIndex) // not mapped is already 0
+			return;
+		m_Directory.resize(page + 1U, 0U);
+	}
+
+	uint32_t& slot = m_Directory[page];
+	if (!slot)
+	{
+		if (!vGlyphIndex)
+			return;
+		if (m_Pages.empty())
+			m_Pages.resize(256U, 0U); // the empty page
+		slot = (uint32_t)(m_Pages.size() >> 8);
+		m_Pages.resize(m_Pages.size() + 256U, 0U);
+	}
+
+	m_Pages[((size_t)slot << 8) | (vCodePoint & 0xFFU)] = vGlyphIndex;
+}
+
+void TTFRRW::CodePointTable::AddRange(const CodePoint& vStart, const CodePoint& vEnd, const GlyphIndex& vGlyphIndex)
+{
+	if (vStart > vEnd || vStart > MAX_CODEPOINT || !vGlyphIndex)
+		return;
+
+	CodePointRange range;
+	range.start = vStart;
+	range.end = mini(vEnd, MAX_CODEPOINT);
+	range.glyphIndex = vGlyphIndex;
+	m_Ranges.push_back(range);
+}
+
+void TTFRRW::CodePointTable::SortRanges()
+{
+	std::sort(m_Ranges.begin(), m_Ranges.end(), 
+		[](const CodePointRange& a, const CodePointRange& b) { return a.start < b.start; });
+}
 
-	WriteByte((uint8_t)((ul >> 24) & 0xff));
-	WriteByte((uint8_t)((ul >> 16) & 0xff));
-	WriteByte((uint8_t)((ul >> 8) & 0xff));
-	WriteByte((uint8_t)(ul & 0xff));
+TTFRRW::GlyphIndex TTFRRW::CodePointTable::GetFromRanges(const CodePoint& vCodePoint) const
+{
+	// the last range starting before the codepoint
+	auto it = std::upper_bound(m_Ranges.begin(), m_Ranges.end(), vCodePoint, 
+		[](const CodePoint& cp, const CodePointRange& range) { return cp < range.start; });
+	if (it != m_Ranges.begin())
+	{
+		--it;
+		if (vCodePoint <= it->end)
+			return it->glyphIndex;
+	}
+	return 0;
 }
 
-void TTFRRW::MemoryStream::WriteLong(const int64_t& l)
+size_t TTFRRW::CodePointTable::GetMemorySize() const
+{
+	return sizeof(m_Latin1) +
+		m_Pages.capacity() * sizeof(GlyphIndex) +
+		m_Directory.capacity() * sizeof(uint32_t) +
+		m_Ranges.capacity() * sizeof(CodePointRange);
+}
+
+TTFRRW::GlyphCodePointsTable::GlyphCodePointsTable(const AllocatorHooks& vHooks)
+	: m_Offsets(HookAllocator<uint32_t>(vHooks)), // the other share its hooks
+	m_CodePoints(m_Offsets.get_allocator())
 {
-	ZoneScoped;
 
-	WriteULong(l);
 }
 
-void TTFRRW::MemoryStream::WriteFixed(const MemoryStream::Fixed& f)
+void TTFRRW::GlyphCodePointsTable::Clear()
 {
-	ZoneScoped;
+	m_Offsets.clear();
+	m_CodePoints.clear();
+}
 
-	WriteByte((uint8_t)((f.high >> 24) & 0xff));
-	WriteByte((uint8_t)((f.high >> 16) & 0xff));
-	WriteByte((uint8_t)((f.low >> 8) & 0xff));
-	WriteByte((uint8_t)(f.low & 0xff));
+void TTFRRW::GlyphCodePointsTable::Build(const CodePointTable& vCodePoints)
+{
+	TTFRRW_ZONE_TABLE;
+
+	Clear();
+
+	// count the codepoints of each glyph, in m_Offsets[glyph + 1]
+	vCodePoints.ForEach([this](const CodePoint&, const GlyphIndex& vGlyphIndex)
+	{
+		if ((size_t)vGlyphIndex + 2U > m_Offsets.size())
+			m_Offsets.resize((size_t)vGlyphIndex + 2U, 0U);
+		m_Offsets[vGlyphIndex + 1U]++;
+	});
+
+	if (m_Offsets.empty())
+		return;
+
+	for (size_t idx = 1; idx < m_Offsets.size(); idx++)
+	{
+		m_Offsets[idx] += m_Offsets[idx - 1U];
+	}
+
+	// the codepoints are visited in order, so each row is sorted
+	std::vector<uint32_t, HookAllocator<uint32_t>> cursors(m_Offsets.begin(), m_Offsets.end() - 1, m_Offsets.get_allocator());
+	m_CodePoints.resize(m_Offsets.back());
+	vCodePoints.ForEach([this, &cursors](const CodePoint& vCodePoint, const GlyphIndex& vGlyphIndex)
+	{
+		m_CodePoints[cursors[vGlyphIndex]++] = vCodePoint;
+	});
 }
 
-void TTFRRW::MemoryStream::WriteF2DOT14(const MemoryStream::F2DOT14& f)
+size_t TTFRRW::GlyphCodePointsTable::GetMemorySize() const
+{
+	return m_Offsets.capacity() * sizeof(uint32_t) +
+		m_CodePoints.capacity() * sizeof(CodePoint);
+}
+
+TTFRRW::VariationSequenceTable::VariationSequenceTable(const AllocatorHooks& vHooks)
+	: m_Selectors(HookAllocator<Selector>(vHooks)), // the others share its hooks
+	m_DefaultRanges(m_Selectors.get_allocator()),
+	m_Glyphs(m_Selectors.get_allocator())
 {
-	ZoneScoped;
 
-	WriteShort(f.value);
 }
 
-void TTFRRW::MemoryStream::WriteDateTime(const longDateTime& date)
+void TTFRRW::VariationSequenceTable::Clear()
 {
-	ZoneScoped;
+	m_Selectors.clear();
+	m_DefaultRanges.clear();
+	m_Glyphs.clear();
+}
 
-	WriteULong((date >> 32) & 0xffffffff); //-V112
-	WriteULong(date & 0xffffffff); //-V112
+void TTFRRW::VariationSequenceTable::AddSelector(const CodePoint& vVarSelector)
+{
+	Selector selector;
+	selector.varSelector = vVarSelector;
+	selector.defaultBegin = selector.defaultEnd = (uint32_t)m_DefaultRanges.size();
+	selector.glyphsBegin = selector.glyphsEnd = (uint32_t)m_Glyphs.size();
+	m_Selectors.push_back(selector);
 }
 
-const uint32_t TTFRRW::MemoryStream::GetTag(const uint8_t& a, const uint8_t& b, const uint8_t& c, const uint8_t& d)
+void TTFRRW::VariationSequenceTable::AddDefaultRange(const CodePoint& vStart, const CodePoint& vEnd)
 {
-	return (d) | (c << 8) | (b << 16) | (a << 24);
+	if (m_Selectors.empty())
+		return;
+
+	CodePointRange range;
+	range.start = vStart;
+	range.end = vEnd;
+	m_DefaultRanges.push_back(range);
+	m_Selectors.back().defaultEnd = (uint32_t)m_DefaultRanges.size();
 }
 
-void TTFRRW::MemoryStream::WriteTag(const std::string& vTag)
+void TTFRRW::VariationSequenceTable::AddGlyph(const CodePoint& vCodePoint, const GlyphIndex& vGlyphIndex)
 {
-	if (vTag.size() >= 4) // only the 4 frist char will be used btw
-	{
-		WriteULong(GetTag(vTag[3], vTag[2], vTag[1], vTag[0]));
-	}
+	if (m_Selectors.empty())
+		return;
+
+	Mapping mapping;
+	mapping.codePoint = vCodePoint;
+	mapping.glyphIndex = vGlyphIndex;
+	m_Glyphs.push_back(mapping);
+	m_Selectors.back().glyphsEnd = (uint32_t)m_Glyphs.size();
 }
 
-void TTFRRW::MemoryStream::WriteString(const std::string& vString)
+TTFRRW::VariationSequenceTable::VariationResult TTFRRW::VariationSequenceTable::Get(
+	const CodePoint& vCodePoint, const CodePoint& vVarSelector, GlyphIndex* vOutGlyphIndex) const
 {
-	for (const auto& s : vString)
+	auto selector = std::lower_bound(m_Selectors.begin(), m_Selectors.end(), vVarSelector,
+		[](const Selector& sel, const CodePoint& vs) { return sel.varSelector < vs; });
+	if (selector == m_Selectors.end() || selector->varSelector != vVarSelector)
+		return VARIATION_NOT_FOUND;
+
+	// the specific glyphs, sorted by codepoint
+	const auto glyphsBegin = m_Glyphs.begin() + selector->glyphsBegin;
+	const auto glyphsEnd = m_Glyphs.begin() + selector->glyphsEnd;
+	auto mapping = std::lower_bound(glyphsBegin, glyphsEnd, vCodePoint,
+		[](const Mapping& map, const CodePoint& cp) { return map.codePoint < cp; });
+	if (mapping != glyphsEnd && mapping->codePoint == vCodePoint)
 	{
-		WriteByte(s);
+		if (vOutGlyphIndex)
+			*vOutGlyphIndex = mapping->glyphIndex;
+		return VARIATION_GLYPH;
 	}
-}
 
-const uint8_t* TTFRRW::MemoryStream::GetDatas() const
-{
-	ZoneScoped;
+	// the ranges using the default glyph, sorted by start
+	const auto rangesBegin = m_DefaultRanges.begin() + selector->defaultBegin;
+	const auto rangesEnd = m_DefaultRanges.begin() + selector->defaultEnd;
+	auto range = std::upper_bound(rangesBegin, rangesEnd, vCodePoint,
+		[](const CodePoint& cp, const CodePointRange& r) { return cp < r.start; });
+	if (range != rangesBegin && vCodePoint <= (range - 1)->end)
+		return VARIATION_DEFAULT;
 
-	return m_Datas.data();
+	return VARIATION_NOT_FOUND;
 }
 
-const size_t TTFRRW::MemoryStream::GetSize() const
+size_t TTFRRW::VariationSequenceTable::GetMemorySize() const
 {
-	ZoneScoped;
-
-	return m_Datas.size();
+	return m_Selectors.capacity() * sizeof(Selector) +
+		m_DefaultRanges.capacity() * sizeof(CodePointRange) +
+		m_Glyphs.capacity() * sizeof(Mapping);
 }
 
-const size_t TTFRRW::MemoryStream::GetPos() const
+///////////////////////////////////////////////////////////////////////
+//// THREAD POOL //////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+// queue of the current thread, set by the workers of a pool
+struct PoolThreadQueue
 {
-	ZoneScoped;
+	const TTFRRW::ThreadPool* pool = nullptr;
+	size_t index = 0U;
+};
+static thread_local PoolThreadQueue s_PoolThreadQueue;
 
-	return m_ReadPos;
+TTFRRW::ThreadPool* TTFRRW::ThreadPool::Instance()
+{
+	// the caller thread is used as a worker too
+	static ThreadPool _instance(maxi(std::thread::hardware_concurrency(), 1U) - 1U);
+	return &_instance;
 }
 
-void TTFRRW::MemoryStream::SetPos(const size_t& vPos)
+TTFRRW::ThreadPool::ThreadPool(const size_t& vThreadCount) : m_QueuedJobs(0U), m_Epoch(0U)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
 
-	m_ReadPos = vPos;
+	// the queues before the workers, they steal in all of them
+	for (size_t idx = 0; idx <= vThreadCount; idx++)
+	{
+		m_Queues.emplace_back(new WorkQueue());
+	}
+
+	for (size_t idx = 0; idx < vThreadCount; idx++)
+	{
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, idx);
+	}
 }
 
-void TTFRRW::MemoryStream::SetDatas(const uint8_t* vDatas, const size_t& vSize)
+TTFRRW::ThreadPool::~ThreadPool()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
 
-	if (vDatas && vSize)
 	{
-		m_Datas.clear();
-		m_Datas.resize(vSize);
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+		m_Epoch++;
+	}
+	m_JobCondition.notify_all();
 
-		memcpy(m_Datas.data(), vDatas, vSize);
+	for (auto& thread : m_Threads)
+	{
+		if (thread.joinable())
+			thread.join();
 	}
 }
 
-////////////////////////////////////////////////////////////////
-//// READ //////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////
+size_t TTFRRW::ThreadPool::GetThreadCount() const
+{
+	return m_Threads.size() + 1U;
+}
 
-const uint8_t TTFRRW::MemoryStream::ReadByte(const size_t& vOffset)
+void TTFRRW::ThreadPool::ParallelFor(const size_t& vCount, const size_t& vGrain, const RangeFunc& vFunc, const size_t& vMaxThreads)
 {
-	ZoneScoped;
+	if (!vCount || !vFunc)
+		return;
 
-	if (vOffset + m_ReadPos < m_Datas.size())
-		return m_Datas[vOffset + m_ReadPos++];
+	TTFRRW_ZONE_TABLE;
 
-	return 0;
+	const size_t grain = maxi(vGrain, (size_t)1U);
+	const size_t chunks = (vCount + grain - 1U) / grain;
+
+	// not worth it, or no workers
+	if (chunks == 1U || vMaxThreads == 1U || m_Threads.empty())
+	{
+		vFunc(0U, vCount);
+		return;
+	}
+
+	auto job = std::make_shared<Job>();
+	job->func = vFunc;
+	job->count = vCount;
+	job->grain = grain;
+	job->chunks = chunks;
+	job->maxWorkers = vMaxThreads ? vMaxThreads - 1U : 0U; // the caller is not counted
+
+	PushJob(job, true);
+
+	RunChunks(job.get());
+
+	// the chunks taken by the other threads are not finished, do other jobs meanwhile
+	HelpUntil([&job]() { return job->doneChunks.load() == job->chunks; });
 }
 
-const std::vector<uint8_t> TTFRRW::MemoryStream::ReadBytes(const size_t& vLen, const size_t& vOffset)
+void TTFRRW::ThreadPool::Submit(const std::function<void()>& vFunc)
 {
-	ZoneScoped;
+	if (!vFunc)
+		return;
 
-	std::vector<uint8_t> res;
+	TTFRRW_ZONE_TABLE;
 
-	if (vOffset + m_ReadPos + vLen < m_Datas.size())
+	if (m_Threads.empty())
 	{
-		auto start = m_Datas.begin() + vOffset + m_ReadPos;
-		auto end = start + vLen;
-		res = std::vector<uint8_t>(start, end);
-		m_ReadPos += vLen;
+		vFunc();
+		return;
 	}
 
-	return res;
+	auto job = std::make_shared<Job>();
+	job->func = [vFunc](const size_t&, const size_t&) { vFunc(); };
+	job->count = 1U;
+	job->grain = 1U;
+	job->chunks = 1U;
 
+	PushJob(job, false);
 }
 
-const int32_t TTFRRW::MemoryStream::ReadUShort(const size_t& vOffset)
+void TTFRRW::ThreadPool::HelpUntil(const std::function<bool()>& vDone)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
 
-	return 0xffff & (ReadByte(vOffset) << 8 | ReadByte(vOffset));
+	const size_t queueIndex = GetQueueIndex();
+	while (true)
+	{
+		// read before the checks, a change after them cancel the sleep
+		const uint64_t epoch = m_Epoch.load();
+		if (vDone())
+			return;
+
+		auto job = PopJob(queueIndex);
+		if (job)
+		{
+			RunChunks(job.get());
+			job->workers--;
+			continue;
+		}
+
+		// vDone become true with a Wake() or the last chunk of a job, both notify
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (m_Epoch.load() == epoch)
+			m_JobCondition.wait(lock);
+	}
 }
 
-const int32_t TTFRRW::MemoryStream::ReadShort(const size_t& vOffset)
+void TTFRRW::ThreadPool::Wake()
 {
-	ZoneScoped;
-
-	return ((ReadByte(vOffset) << 8 | ReadByte(vOffset)) << 16) >> 16;
+	Notify();
+	m_JobCondition.notify_all();
 }
 
-const TTFRRW::MemoryStream::FWord TTFRRW::MemoryStream::ReadFWord(const size_t& vOffset)
+void TTFRRW::ThreadPool::WorkerLoop(const size_t& vQueueIndex)
 {
-	ZoneScoped;
+	s_PoolThreadQueue.pool = this;
+	s_PoolThreadQueue.index = vQueueIndex;
 
-	return (int16_t)ReadShort(vOffset);
+	while (true)
+	{
+		// read before the search, a job pushed after it cancel the sleep
+		const uint64_t epoch = m_Epoch.load();
+
+		auto job = PopJob(vQueueIndex);
+		if (job)
+		{
+			RunChunks(job.get());
+			job->workers--;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (!m_Stop && m_Epoch.load() == epoch)
+			m_JobCondition.wait(lock);
+		if (m_Stop)
+			return;
+	}
 }
 
-const TTFRRW::MemoryStream::UFWord TTFRRW::MemoryStream::ReadUFWord(const size_t& vOffset)
+size_t TTFRRW::ThreadPool::GetQueueIndex() const
 {
-	ZoneScoped;
-
-	return (uint16_t)ReadUShort(vOffset);
+	if (s_PoolThreadQueue.pool == this)
+		return s_PoolThreadQueue.index;
+	return m_Queues.size() - 1U; // thread out of the pool
 }
 
-const uint32_t TTFRRW::MemoryStream::ReadUInt24(const size_t& vOffset)
+void TTFRRW::ThreadPool::PushJob(const std::shared_ptr<Job>& vJob, const bool& vWakeAll)
 {
-	ZoneScoped;
+	WorkQueue* queue = m_Queues[GetQueueIndex()].get();
+	{
+		std::unique_lock<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(vJob);
+	}
+	m_QueuedJobs++;
+	TTFRRW_PLOT("TTFRRW pool queue", m_QueuedJobs.load());
 
-	return 0xffffff & (ReadByte(vOffset) << 16 | ReadByte(vOffset) << 8 | ReadByte(vOffset));
+	Notify();
+	if (vWakeAll) // many chunks, all the idle threads can help
+		m_JobCondition.notify_all();
+	else
+		m_JobCondition.notify_one();
 }
 
-const uint64_t TTFRRW::MemoryStream::ReadULong(const size_t& vOffset)
+std::shared_ptr<TTFRRW::ThreadPool::Job> TTFRRW::ThreadPool::PopJob(const size_t& vQueueIndex)
 {
-	ZoneScoped;
+	// its own queue first, the newest job is the nested one of the job in progress, its datas are in the cache
+	auto job = TakeJob(m_Queues[vQueueIndex].get(), true);
 
-	return 0xffffffffL & ReadLong(vOffset); //-V112
+	// else steal the oldest job of the other queues, starting from the next one for spread the thefts
+	const size_t queuesCount = m_Queues.size();
+	for (size_t offset = 1U; !job && offset < queuesCount; offset++)
+	{
+		job = TakeJob(m_Queues[(vQueueIndex + offset) % queuesCount].get(), false);
+	}
+
+	return job;
 }
 
-const uint32_t TTFRRW::MemoryStream::ReadULongAsInt(const size_t& vOffset)
+std::shared_ptr<TTFRRW::ThreadPool::Job> TTFRRW::ThreadPool::TakeJob(WorkQueue* vQueue, const bool& vNewestFirst)
 {
-	ZoneScoped;
+	std::unique_lock<std::mutex> lock(vQueue->mutex);
 
-	const int64_t ulong = ReadULong(vOffset);
-	return ((int32_t)ulong) & ~0x80000000; //-V112
+	// a job with no more chunks to take leave the queue, its running chunks will finish normally
+	// a job full of workers is skipped
+	auto& jobs = vQueue->jobs;
+	size_t idx = 0;
+	while (idx < jobs.size())
+	{
+		const size_t pos = vNewestFirst ? jobs.size() - 1U - idx : idx;
+		Job* ptr = jobs[pos].get();
+		if (ptr->nextChunk.load() >= ptr->chunks)
+		{
+			jobs.erase(jobs.begin() + pos); // the next job is at the same idx
+			m_QueuedJobs--;
+			TTFRRW_PLOT("TTFRRW pool queue", m_QueuedJobs.load());
+		}
+		else if (ptr->maxWorkers && ptr->workers.load() >= ptr->maxWorkers)
+		{
+			idx++;
+		}
+		else
+		{
+			auto job = jobs[pos];
+			job->workers++;
+			return job;
+		}
+	}
+
+	return nullptr;
 }
 
-const int32_t TTFRRW::MemoryStream::ReadLong(const size_t& vOffset)
+void TTFRRW::ThreadPool::Notify()
 {
-	ZoneScoped;
-
-	return
-		ReadByte(vOffset) << 24 |
-		ReadByte(vOffset) << 16 |
-		ReadByte(vOffset) << 8 |
-		ReadByte(vOffset);
+	// under the lock, else a thread between its epoch check and its wait miss it
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Epoch++;
 }
 
-const TTFRRW::MemoryStream::Fixed TTFRRW::MemoryStream::ReadFixed(const size_t& vOffset)
+void TTFRRW::ThreadPool::RunChunks(Job* vJob)
 {
-	ZoneScoped;
+	size_t chunk = vJob->nextChunk++;
+	while (chunk < vJob->chunks)
+	{
+		const size_t begin = chunk * vJob->grain;
+		const size_t end = mini(begin + vJob->grain, vJob->count);
+		vJob->func(begin, end);
 
-	Fixed res;
-	const int32_t f = ReadLong(vOffset);
-	res.high = (int16_t)((f >> 16) & 0xff);
-	res.low = (int16_t)(f & 0xff);
-	return res;
+		if (++vJob->doneChunks == vJob->chunks)
+		{
+			// the caller of the job wait in HelpUntil
+			Notify();
+			m_JobCondition.notify_all();
+		}
+
+		chunk = vJob->nextChunk++;
+	}
 }
 
-const TTFRRW::MemoryStream::F2DOT14 TTFRRW::MemoryStream::ReadF2DOT14(const size_t& vOffset)
+///////////////////////////////////////////////////////////////////////
+//// TASK GRAPH ///////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+TTFRRW::TaskGraph::TaskGraph() : m_RemainingTasks(0U)
 {
-	ZoneScoped;
 
-	F2DOT14 res;
-	res.value = (int16_t)ReadShort(vOffset);
-	return res;
 }
 
-const TTFRRW::MemoryStream::longDateTime TTFRRW::MemoryStream::ReadDateTime(const size_t& vOffset)
+size_t TTFRRW::TaskGraph::AddTask(const TaskFunc& vFunc, const std::vector<size_t>& vDependencies)
 {
-	ZoneScoped;
+	const size_t id = m_Tasks.size();
 
-	return (int64_t)ReadULong(vOffset) << 32 | ReadULong(vOffset); //-V112
+	std::unique_ptr<Task> task(new Task());
+	task->func = vFunc;
+	for (const auto& dep : vDependencies)
+	{
+		if (dep < id) // only the previous tasks, so no cycles
+		{
+			m_Tasks[dep]->successors.push_back(id);
+			task->dependencyCount++;
+		}
+	}
+	m_Tasks.push_back(std::move(task));
+
+	return id;
 }
 
-const std::string TTFRRW::MemoryStream::ReadString(const size_t& vLen, const size_t& vOffset)
+void TTFRRW::TaskGraph::Run(ThreadPool* vPool, const size_t& vMaxThreads)
 {
-	if (vOffset + m_ReadPos + vLen < m_Datas.size())
+	if (m_Tasks.empty())
+		return;
+
+	TTFRRW_ZONE_TABLE;
+
+	m_Pool = vPool;
+
+	for (auto& task : m_Tasks)
 	{
-		ZoneScoped;
+		task->pendingDependencies.store(task->dependencyCount);
+	}
 
-		const std::string res = std::string((char*)(m_Datas.data() + vOffset + m_ReadPos), vLen);
-		m_ReadPos += vLen;
-		return res;
+	if (!m_Pool || vMaxThreads == 1U || m_Pool->GetThreadCount() == 1U)
+	{
+		// the tasks are added after there dependencies, so the order of creation is fine
+		for (auto& task : m_Tasks)
+		{
+			if (task->func)
+				task->func();
+		}
+		return;
 	}
-	return "";
+
+	m_RemainingTasks.store(m_Tasks.size());
+
+	std::vector<size_t> roots;
+	for (size_t id = 0; id < m_Tasks.size(); id++)
+	{
+		if (!m_Tasks[id]->dependencyCount)
+			roots.push_back(id);
+	}
+
+	// the caller run the first root, and help the pool until the end
+	for (size_t idx = 1; idx < roots.size(); idx++)
+	{
+		const size_t id = roots[idx];
+		m_Pool->Submit([this, id]() { Execute(id); });
+	}
+	Execute(roots[0]);
+
+	m_Pool->HelpUntil([this]() { return m_RemainingTasks.load() == 0U; });
 }
 
-const std::string TTFRRW::MemoryStream::ReadTag(const size_t& vOffset)
+void TTFRRW::TaskGraph::Execute(size_t vTaskId)
 {
-	ZoneScoped;
+	while (true)
+	{
+		Task* task = m_Tasks[vTaskId].get();
+		if (task->func)
+			task->func();
 
-	std::string res = "OOOO"; // 4
-	uint32_t _tag = (uint32_t)ReadULong(vOffset);
-	res[0] = (uint8_t)((_tag >> 24) & 0xff);
-	res[1] = (uint8_t)((_tag >> 16) & 0xff);
-	res[2] = (uint8_t)((_tag >> 8) & 0xff);
-	res[3] = (uint8_t)(_tag & 0xff);
-	return res;
+		std::vector<size_t> readyTasks;
+		for (const auto& id : task->successors)
+		{
+			if (--m_Tasks[id]->pendingDependencies == 0U)
+				readyTasks.push_back(id);
+		}
+
+		// the graph can be destroyed by Run as soon as the last task is counted
+		ThreadPool* pool = m_Pool;
+		if (--m_RemainingTasks == 0U)
+		{
+			pool->Wake();
+			return;
+		}
+
+		if (readyTasks.empty())
+			return;
+
+		// the first ready task continue on this thread, the others go to the pool
+		for (size_t idx = 1; idx < readyTasks.size(); idx++)
+		{
+			const size_t id = readyTasks[idx];
+			m_Pool->Submit([this, id]() { Execute(id); });
+		}
+		vTaskId = readyTasks[0];
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 
-#define ATOMIC_RETURN_IF_STOP_WORKING(v) if (vWorking) if (!vWorking->load()) return v;
-#define ATOMIC_PROGRESS_ADD(v) if (vProgress) vProgress->store(vProgress->load() + v)
-#define ATOMIC_OBJECTS_COUNT_INC if (vObjectCount) vObjectCount->store(vObjectCount->load() + 1U)
+// the counts of a thread are published every PROGRESS_PUBLISH_PERIOD units, with a relaxed fetch_add
+// so the atomics of the caller are not contended when the parsing is multi threaded
+#define PROGRESS_PUBLISH_PERIOD 64U
+
+// the progress published by many threads only grow,
+// a thread who counted before another can publish after it, its smaller value is then ignored
+static void PublishProgress(std::atomic<float>* vProgress, const float& vValue)
+{
+	float current = vProgress->load(std::memory_order_relaxed);
+	while (current < vValue && !vProgress->compare_exchange_weak(current, vValue, std::memory_order_relaxed))
+	{
+	}
+}
+
+// objects count and progress of a parsing, counted by one thread
+// the progress is optional, the units done are shared by the counters of the threads
+// what is not published is published at the destruction
+class ProgressCounter
+{
+private:
+	std::atomic<uint32_t>* m_ObjectCount = nullptr;
+	std::atomic<float>* m_Progress = nullptr;
+	std::atomic<uint32_t>* m_UnitsDone = nullptr;
+	float m_UnitsTotal = 0.0f;
+	uint32_t m_Pending = 0U;
+
+public:
+	explicit ProgressCounter(std::atomic<uint32_t>* vObjectCount)
+		: m_ObjectCount(vObjectCount)
+	{
+
+	}
+
+	ProgressCounter(std::atomic<uint32_t>* vObjectCount, std::atomic<float>* vProgress, std::atomic<uint32_t>* vUnitsDone, const size_t& vUnitsTotal)
+		: m_ObjectCount(vObjectCount), m_Progress(vProgress), m_UnitsDone(vUnitsDone), m_UnitsTotal((float)vUnitsTotal)
+	{
+
+	}
+
+	~ProgressCounter()
+	{
+		Publish();
+	}
+
+	// return true when the count is published, the time for check the cancel
+	bool Add()
+	{
+		if (++m_Pending < PROGRESS_PUBLISH_PERIOD)
+			return false;
+		Publish();
+		return true;
+	}
+
+	void Publish()
+	{
+		if (!m_Pending)
+			return;
+		if (m_ObjectCount)
+			m_ObjectCount->fetch_add(m_Pending, std::memory_order_relaxed);
+		if (m_UnitsDone)
+		{
+			const uint32_t done = m_UnitsDone->fetch_add(m_Pending, std::memory_order_relaxed) + m_Pending;
+			if (m_Progress && m_UnitsTotal > 0.0f)
+				PublishProgress(m_Progress, (float)done / m_UnitsTotal);
+		}
+		m_Pending = 0U;
+	}
+};
+
+// the cancel is only a request, so a relaxed load is enough
+#define ATOMIC_RETURN_IF_STOP_WORKING(v) if (vWorking) if (!vWorking->load(std::memory_order_relaxed)) return v;
+#define ATOMIC_OBJECTS_COUNT_INC if (vObjectCount) vObjectCount->fetch_add(1U, std::memory_order_relaxed)
+// count an object on the counter of the thread, the cancel is checked when the count is published
+#define ATOMIC_OBJECTS_COUNT_ADD(counter, v) if (counter.Add()) { ATOMIC_RETURN_IF_STOP_WORKING(v); }
 
 TTFRRW::TTFRRW::TTFRRW()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+
+	for (auto& counter : m_MemoryCounters)
+	{
+		counter = std::make_shared<MemoryCounter>();
+	}
+	ResetContainers();
 }
 
 TTFRRW::TTFRRW::~TTFRRW()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+}
+
+TTFRRW::AllocatorHooks TTFRRW::TTFRRW::GetCountedHooks(const MemoryCategory& vCategory) const
+{
+	AllocatorHooks hooks = m_AllocatorHooks;
+	hooks.counter = m_MemoryCounters[vCategory];
+	return hooks;
+}
+
+void TTFRRW::TTFRRW::ResetContainers()
+{
+	m_Glyphs = GlyphArray(HookAllocator<Glyph>(GetCountedHooks(MEMORY_CATEGORY_GLYPHS)));
+	m_GlyphAllocators.names = HookAllocator<char>(GetCountedHooks(MEMORY_CATEGORY_GLYPH_NAMES));
+	m_GlyphAllocators.layers = HookAllocator<char>(GetCountedHooks(MEMORY_CATEGORY_LAYERS));
+	m_GlyphAllocators.composites = HookAllocator<char>(GetCountedHooks(MEMORY_CATEGORY_COMPOSITES));
+	m_Outlines.reset();
+	ResetSharedTables();
+	m_Names = NameSet(NameSet::allocator_type(GetCountedHooks(MEMORY_CATEGORY_NAMES)));
+	m_Palettes = std::vector<PaletteColors, HookAllocator<PaletteColors>>(HookAllocator<PaletteColors>(GetCountedHooks(MEMORY_CATEGORY_PALETTES)));
+	const HookAllocator<char> tablesAllocator(GetCountedHooks(MEMORY_CATEGORY_TABLES));
+	m_Tables = TableMap(TableMap::allocator_type(tablesAllocator));
+	m_FontStream = MemoryStream(GetCountedHooks(MEMORY_CATEGORY_STREAM));
+
+	std::unique_lock<std::mutex> lock(m_GlyphCache.mutex);
+	m_GlyphCache.size = 0U;
+	m_GlyphCache.lru = GlyphCache::LRU(GlyphCache::LRU::allocator_type(tablesAllocator));
+	m_GlyphCache.entries = GlyphCache::Entries(GlyphCache::Entries::allocator_type(tablesAllocator));
+}
+
+void TTFRRW::TTFRRW::ResetSharedTables()
+{
+	const AllocatorHooks cmapHooks = GetCountedHooks(MEMORY_CATEGORY_CMAP);
+	m_GlyphNames = std::make_shared<const GlyphNameArray>(GlyphNameArray::allocator_type(m_GlyphAllocators.names));
+	m_CodePoint_To_GlyphIndex = std::make_shared<const CodePointTable>(cmapHooks);
+	m_VariationSequences = std::make_shared<const VariationSequenceTable>(cmapHooks);
+	m_GlyphIndex_To_CodePoints = std::make_shared<const GlyphCodePointsTable>(cmapHooks);
+	m_GlyphsOffsets = std::make_shared<const GlyphsOffsets>(HookAllocator<size_t>(GetCountedHooks(MEMORY_CATEGORY_LOCA)));
+}
+
+void TTFRRW::TTFRRW::PlotFontState() const
+{
+#ifdef TRACY_ENABLE
+	int64_t heapBytes = 0;
+	for (const auto& counter : m_MemoryCounters)
+	{
+		if (counter)
+			heapBytes += counter->bytes.load(std::memory_order_relaxed);
+	}
+	TTFRRW_PLOT("TTFRRW glyphs", m_Glyphs.size());
+	TTFRRW_PLOT("TTFRRW heap in use", heapBytes);
+#endif
 }
 
 void TTFRRW::TTFRRW::Clear(TTFRRW_ATOMIC_PARAMS)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
 
 	(void)vWorking;
 	if (vProgress && vObjectCount)
@@ -521,21 +2634,37 @@ void TTFRRW::TTFRRW::Clear(TTFRRW_ATOMIC_PARAMS)
 	}
 
 	m_TTFInfos = TTFInfos();
-	m_TTFProfiler.Reset();
 
 	m_IsValid_For_Rasterize = false;
 	m_IsValid_For_GlyphTreatment = false;
 
 	m_Glyphs.clear();
-	m_GlyphNames.clear();
-	m_CodePoint_To_GlyphIndex.clear();
-	m_GlyphIndex_To_CodePoints.clear();
+	if (m_Outlines.use_count() == 1)
+		m_Outlines->Clear(); // the memory is reused by the next font
+	else
+		m_Outlines.reset(); // shared with another face
+	ResetSharedTables(); // can be shared with another face, so not cleared in place
 	m_Names.clear();
 	m_Tables.clear();
 	m_IndexToLocFormat = 0;
-	m_GlyphsOffsets.clear();
 	m_Palettes.clear();
 	m_MumOfLongHorMetrics = 0;
+	m_FacesCount = 0U;
+
+	m_FontStream.Release();
+	m_LazyFlags = 0;
+	m_IsLazy = false;
+	for (auto& guard : m_LazyTables)
+	{
+		guard.Reset();
+	}
+
+	std::unique_lock<std::mutex> lock(m_GlyphCache.mutex);
+	m_GlyphsFlags = 0;
+	m_IsGlyphsOnDemand = false;
+	m_GlyphCache.size = 0U;
+	m_GlyphCache.lru.clear();
+	m_GlyphCache.entries.clear(); // the outlines in use stay alive in their views
 }
 
 bool TTFRRW::TTFRRW::OpenFontFile(
@@ -544,55 +2673,74 @@ bool TTFRRW::TTFRRW::OpenFontFile(
 	const char* vDebugInfos,
 	TTFRRW_ATOMIC_PARAMS)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+	TTFRRW_FRAME_OPEN;
 
 	bool res = false;
-#ifdef USE_SIMPLE_PROFILER
-	cProfiler mainProfiler;
-	mainProfiler.start();
-#endif
-	MemoryStream mem;
-
-	int error = 0;
-	res = LoadFileToMemory(vFontFilePathName, &mem, &error);
-	if (res)
+	m_TTFProfiler.Reset();
 	{
-		res = Parse_Font_File(&mem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
+		// the tables parsers are nested in the open
+		TimingScope timing(&m_TTFProfiler.timings, TimingRegistry::ROOT_NODE, "OpenFontFile");
+		m_TTFProfiler.stageNode = timing.GetNode();
+
+		MemoryStream mem(GetCountedHooks(MEMORY_CATEGORY_STREAM));
+
+		int error = 0;
+		{
+			TimingScope loadTiming(&m_TTFProfiler.timings, timing.GetNode(), "LoadFileToMemory");
+			res = LoadFileToMemory(vFontFilePathName, &mem, &error);
+		}
+		if (res)
+		{
+			res = Parse_Font_File(&mem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
+			if (res && (m_IsLazy || m_IsGlyphsOnDemand))
+			{
+				// the mapping is kept for the tables and the glyphs parsed later
+				m_FontStream = std::move(mem);
+			}
+		}
+
+		m_TTFProfiler.stageNode = TimingRegistry::ROOT_NODE; // the lazy tables are parsed after the open
 	}
-#ifdef USE_SIMPLE_PROFILER
-	mainProfiler.end();
-	mainProfiler.print(vFlags, "OpenFontFile ", vDebugInfos);
-#else
-	(void)vDebugInfos;
-#endif
+	m_TTFProfiler.Print(vFlags, vDebugInfos);
+	PlotFontState();
 	return res;
 }
 
 bool TTFRRW::TTFRRW::OpenFontStream(
-	uint8_t* vStream, const size_t& vStreamSize,
+	const uint8_t* vStream, const size_t& vStreamSize,
 	ttfrrwProcessingFlags vFlags,
 	const char* vDebugInfos,
 	TTFRRW_ATOMIC_PARAMS)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+	TTFRRW_FRAME_OPEN;
 
 	bool res = false;
-#ifdef USE_SIMPLE_PROFILER
-	cProfiler mainProfiler;
-	mainProfiler.start();
-#endif
+	m_TTFProfiler.Reset();
 	if (vStream && vStreamSize)
 	{
-		MemoryStream mem;
-		mem.SetDatas(vStream, vStreamSize);
+		// the tables parsers are nested in the open
+		TimingScope timing(&m_TTFProfiler.timings, TimingRegistry::ROOT_NODE, "OpenFontStream");
+		m_TTFProfiler.stageNode = timing.GetNode();
+
+		// parsed in place, the caller keep the stream alive during the parsing
+		MemoryStream mem(GetCountedHooks(MEMORY_CATEGORY_STREAM));
+		mem.BorrowDatas(vStream, vStreamSize);
 		res = Parse_Font_File(&mem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
+		if (res && (m_IsLazy || m_IsGlyphsOnDemand))
+		{
+			// in lazy or on demand mode, the stream is read after the open
+			// it is copied, unless the caller borrow it and keep it alive while the font is used
+			if (!(vFlags & TTFRRW_PROCESSING_FLAG_BORROW_STREAM))
+				mem.MakeOwner();
+			m_FontStream = std::move(mem);
+		}
+
+		m_TTFProfiler.stageNode = TimingRegistry::ROOT_NODE; // the lazy tables are parsed after the open
 	}
-#ifdef USE_SIMPLE_PROFILER
-	mainProfiler.end();
-	mainProfiler.print(vFlags, "OpenFontStream ", vDebugInfos);
-#else
-	(void)vDebugInfos;
-#endif
+	m_TTFProfiler.Print(vFlags, vDebugInfos);
+	PlotFontState();
 	return res;
 }
 
@@ -600,25 +2748,35 @@ bool TTFRRW::TTFRRW::OpenFontStream(
 // put codepoint in each glyphs
 void TTFRRW::TTFRRW::ConsolidateGlyphs()
 {
+	EnsureTable(LAZY_TABLE_CMAP);
+	EnsureGlyphs();
+
 	for (size_t idx = 0; idx < m_Glyphs.size(); idx++)
 	{
-		GlyphIndex gi = (GlyphIndex)idx;
-		if (m_GlyphIndex_To_CodePoints.find(gi) != m_GlyphIndex_To_CodePoints.end())
+		const CodePointSpan cdps = m_GlyphIndex_To_CodePoints->Get((GlyphIndex)idx);
+		if (!cdps.empty())
 		{
-			auto cdps = m_GlyphIndex_To_CodePoints[gi];
-			if (!cdps.empty())
-			{
-				m_Glyphs[idx].m_CodePoint = *cdps.begin();
-			}
+			m_Glyphs[idx].m_CodePoint = cdps[0];
 		}
 	}
 }
 
-std::vector<TTFRRW::Glyph>* TTFRRW::TTFRRW::GetGlyphs()
+const TTFRRW::TTFRRW::NameSet& TTFRRW::TTFRRW::GetNames()
+{
+	TTFRRW_ZONE_API;
+
+	EnsureTable(LAZY_TABLE_NAME);
+
+	return m_Names;
+}
+
+TTFRRW::TTFRRW::GlyphArray* TTFRRW::TTFRRW::GetGlyphs()
 {
+	EnsureGlyphs();
+
 	if (!m_Glyphs.empty())
 	{
-		ZoneScoped;
+		TTFRRW_ZONE_API;
 
 		return &m_Glyphs;
 	}
@@ -628,11 +2786,13 @@ std::vector<TTFRRW::Glyph>* TTFRRW::TTFRRW::GetGlyphs()
 
 TTFRRW::Glyph* TTFRRW::TTFRRW::GetGlyphWithGlyphIndex(const GlyphIndex& vGlyphIndex)
 {
+	EnsureGlyphs();
+
 	if (vGlyphIndex)
 	{
 		if (vGlyphIndex < m_Glyphs.size())
 		{
-			ZoneScoped;
+			TTFRRW_ZONE_GLYPH;
 
 			return &m_Glyphs[vGlyphIndex];
 		}
@@ -641,9 +2801,42 @@ TTFRRW::Glyph* TTFRRW::TTFRRW::GetGlyphWithGlyphIndex(const GlyphIndex& vGlyphIn
 	return nullptr;
 }
 
+TTFRRW::GlyphOutline TTFRRW::TTFRRW::GetGlyphOutlineWithGlyphIndex(const GlyphIndex& vGlyphIndex)
+{
+	const Glyph* glyph = GetGlyphWithGlyphIndex(vGlyphIndex);
+	if (!glyph)
+		return GlyphOutline();
+
+	TTFRRW_ZONE_GLYPH;
+
+	if (m_IsGlyphsOnDemand)
+		return EnsureGlyphOutline(vGlyphIndex);
+
+	// the outlines of the font, kept alive by the view after the next open
+	GlyphOutline outline;
+	outline.m_Glyph = glyph;
+	if (glyph->m_Outlines)
+	{
+		outline.m_Outlines = m_Outlines;
+		outline.m_FirstContour = glyph->m_FirstContour;
+		outline.m_ContoursCount = glyph->m_ContoursCount;
+	}
+	return outline;
+}
+
+TTFRRW::GlyphOutline TTFRRW::TTFRRW::GetGlyphOutlineWithCodePoint(const CodePoint& vCodePoint)
+{
+	TTFRRW_ZONE_GLYPH;
+
+	const GlyphIndex glyphIndex = GetGlyphIndexFromCodePoint(vCodePoint);
+
+	return GetGlyphOutlineWithGlyphIndex(glyphIndex);
+}
+
 bool TTFRRW::TTFRRW::WriteFontFile(const std::string& vFontFilePathName)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+	TTFRRW_FRAME_WRITE;
 
 	(void)vFontFilePathName;
 
@@ -656,7 +2849,7 @@ bool TTFRRW::TTFRRW::WriteFontFile(const std::string& vFontFilePathName)
 
 void TTFRRW::TTFRRW::AddGlyph(const Glyph& vGlyph, const CodePoint& vCodePoint)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_GLYPH;
 
 	(void)vGlyph;
 	(void)vCodePoint;
@@ -664,58 +2857,167 @@ void TTFRRW::TTFRRW::AddGlyph(const Glyph& vGlyph, const CodePoint& vCodePoint)
 
 TTFRRW::Glyph* TTFRRW::TTFRRW::GetGlyphWithCodePoint(const CodePoint& vCodePoint)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_GLYPH;
 
-	(void)vCodePoint;
+	const GlyphIndex glyphIndex = GetGlyphIndexFromCodePoint(vCodePoint);
 
-	return nullptr;
+	return GetGlyphWithGlyphIndex(glyphIndex);
 }
 
 TTFRRW::GlyphIndex TTFRRW::TTFRRW::GetGlyphIndexFromCodePoint(const CodePoint& vCodePoint)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_GLYPH;
 
-	if (m_CodePoint_To_GlyphIndex.find(vCodePoint) != m_CodePoint_To_GlyphIndex.end())
-	{
-		return m_CodePoint_To_GlyphIndex[vCodePoint];
-	}
+	EnsureTable(LAZY_TABLE_CMAP);
 
-	return 0;
+	return m_CodePoint_To_GlyphIndex->Get(vCodePoint);
 }
 
-std::set<TTFRRW::CodePoint>* TTFRRW::TTFRRW::GetCodePointsFromGlyphIndex(const GlyphIndex& vGlyphIndex)
+TTFRRW::GlyphIndex TTFRRW::TTFRRW::GetGlyphIndexFromCodePoint(const CodePoint& vCodePoint, const CodePoint& vVarSelector)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_GLYPH;
 
-	if (m_GlyphIndex_To_CodePoints.find(vGlyphIndex) != m_GlyphIndex_To_CodePoints.end())
-	{
-		return &m_GlyphIndex_To_CodePoints[vGlyphIndex];
-	}
+	EnsureTable(LAZY_TABLE_CMAP);
 
-	return nullptr;
+	GlyphIndex glyphIndex = 0;
+	if (m_VariationSequences->Get(vCodePoint, vVarSelector, &glyphIndex) == VariationSequenceTable::VARIATION_GLYPH)
+		return glyphIndex;
+
+	return m_CodePoint_To_GlyphIndex->Get(vCodePoint);
+}
+
+TTFRRW::CodePointSpan TTFRRW::TTFRRW::GetCodePointsFromGlyphIndex(const GlyphIndex& vGlyphIndex)
+{
+	TTFRRW_ZONE_GLYPH;
+
+	EnsureTable(LAZY_TABLE_CMAP);
+
+	return m_GlyphIndex_To_CodePoints->Get(vGlyphIndex);
 }
 
 TTFRRW::TTFInfos TTFRRW::TTFRRW::GetFontInfos()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+
+	EnsureTable(LAZY_TABLE_MAXP);
+	EnsureTable(LAZY_TABLE_HEAD);
+	EnsureTable(LAZY_TABLE_HHEA);
 
 	return m_TTFInfos;
 }
 
+TTFRRW::TTFProfiler* TTFRRW::TTFRRW::GetProfiler()
+{
+	return &m_TTFProfiler;
+}
+
 bool TTFRRW::TTFRRW::IsValidForRasterize()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+
+	if (m_IsLazy)
+		return EnsureGlyphs() && EnsureTable(LAZY_TABLE_HMTX);
 
 	return m_IsValid_For_Rasterize;
 }
 
 bool TTFRRW::TTFRRW::IsValidFotGlyppTreatment()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
+
+	if (m_IsLazy)
+		return EnsureGlyphs();
 
 	return m_IsValid_For_GlyphTreatment;
 }
 
+void TTFRRW::TTFRRW::SetThreadCount(const size_t& vThreadCount)
+{
+	m_ThreadCount = vThreadCount;
+}
+
+size_t TTFRRW::TTFRRW::GetThreadCount()
+{
+	if (m_ThreadCount)
+		return mini(m_ThreadCount, ThreadPool::Instance()->GetThreadCount());
+	return ThreadPool::Instance()->GetThreadCount();
+}
+
+void TTFRRW::TTFRRW::SetAllocatorHooks(const AllocatorHooks& vHooks)
+{
+	TTFRRW_ZONE_API;
+
+	Clear(nullptr, nullptr, nullptr);
+
+	// all the memory of the previous hooks is released, 
+	// the containers are rebuilt with the new hooks
+	m_AllocatorHooks = vHooks;
+	m_AllocatorHooks.counter.reset(); // the font have a counter by category
+	ResetContainers();
+}
+
+const TTFRRW::AllocatorHooks& TTFRRW::TTFRRW::GetAllocatorHooks() const
+{
+	return m_AllocatorHooks;
+}
+
+TTFRRW::MemoryStats TTFRRW::TTFRRW::GetMemoryStats()
+{
+	TTFRRW_ZONE_API;
+
+	static const char* s_CategoryNames[MEMORY_CATEGORY_Count] = { 
+		"stream", "glyphs", "outlines", "cmap", "loca", 
+		"glyph_names", "layers", "composites", "names", "palettes", "tables" };
+
+	MemoryStats stats;
+	for (size_t idx = 0; idx < (size_t)MEMORY_CATEGORY_Count; idx++)
+	{
+		auto& category = stats.categories[idx];
+		category.name = s_CategoryNames[idx];
+		const auto& counter = m_MemoryCounters[idx];
+		category.bytes = (size_t)maxi(counter->bytes.load(std::memory_order_relaxed), (int64_t)0);
+		category.allocations = (size_t)maxi(counter->allocations.load(std::memory_order_relaxed), (int64_t)0);
+		category.totalAllocations = (size_t)counter->totalAllocations.load(std::memory_order_relaxed);
+		stats.bytes += category.bytes;
+		stats.allocations += category.allocations;
+	}
+
+	return stats;
+}
+
+void TTFRRW::TTFRRW::SetGlyphCacheBudget(const size_t& vBytes)
+{
+	std::unique_lock<std::mutex> lock(m_GlyphCache.mutex);
+	m_GlyphCache.budget = vBytes;
+	TrimGlyphCache();
+}
+
+size_t TTFRRW::TTFRRW::GetGlyphCacheBudget()
+{
+	return m_GlyphCache.GetBudget();
+}
+
+size_t TTFRRW::TTFRRW::GetGlyphCacheSize()
+{
+	std::unique_lock<std::mutex> lock(m_GlyphCache.mutex);
+	return m_GlyphCache.size;
+}
+
+void TTFRRW::TTFRRW::SetFaceIndex(const size_t& vFaceIndex)
+{
+	m_FaceIndex = vFaceIndex;
+}
+
+size_t TTFRRW::TTFRRW::GetFaceIndex()
+{
+	return m_FaceIndex;
+}
+
+size_t TTFRRW::TTFRRW::GetFacesCount()
+{
+	return m_FacesCount;
+}
+
 ///////////////////////////////////////////////////////////////////////
 //// PRIVATE FILE / STREAM ////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
@@ -725,12 +3027,19 @@ bool TTFRRW::TTFRRW::LoadFileToMemory(
 	MemoryStream* vOutMem,
 	int* vError)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
 
 	bool res = false;
 
 	if (vOutMem)
 	{
+		// zero copy, the file is mapped and parsed in place
+		if (vOutMem->MapFile(vFilePathName, vError))
+		{
+			return true;
+		}
+
+		// fallback if the file can't be mapped (empty or special file)
 		FILE* intput_file = NULL;
 #if defined(MSVC)
 		errno_t returnValue = fopen_s(&intput_file, vFilePathName.c_str(), "rb");
@@ -750,11 +3059,11 @@ bool TTFRRW::TTFRRW::LoadFileToMemory(
 
 			if (fileSize)
 			{
-				// copy the file into the buffer and close
-				std::vector<uint8_t> bytes;
-				bytes.resize(fileSize);
-				fread(bytes.data(), 1, fileSize, intput_file);
-				vOutMem->SetDatas(bytes.data(), bytes.size());
+				// read the file directly in the buffer of the stream and close
+				vOutMem->Release();
+				uint8_t* bytes = vOutMem->ResizeDatas(fileSize);
+				const size_t readSize = fread(bytes, 1, fileSize, intput_file);
+				vOutMem->ResizeDatas(readSize);
 			}
 
 			fclose(intput_file);
@@ -771,7 +3080,7 @@ bool TTFRRW::TTFRRW::WriteMemoryToFile(
 	const MemoryStream& vInMem,
 	int* vError)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
 
 	bool res = false;
 
@@ -803,7 +3112,7 @@ bool TTFRRW::TTFRRW::WriteMemoryToFile(
 
 bool TTFRRW::TTFRRW::Parse_Font_File(MemoryStream* vMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
 {
-	ZoneScoped;
+	TTFRRW_ZONE_API;
 
 	// la loca contient la position des glyphs et leur taille
 	// la maxp contient le nombre de glyphs
@@ -824,6 +3133,11 @@ bool TTFRRW::TTFRRW::Parse_Font_File(MemoryStream* vMem, const ttfrrwProcessingF
 	{
 		Clear(TTFRRW_ATOMIC_PARAMS_BY_REF);
 
+		// the glyf table will read only the glyphs headers, the outlines are decoded by EnsureGlyphOutline
+		m_IsGlyphsOnDemand = (vFlags & TTFRRW_PROCESSING_FLAG_ON_DEMAND_GLYPHS) && 
+			!(vFlags & TTFRRW_PROCESSING_FLAG_NO_GLYPH_PARSING);
+		m_GlyphsFlags = vFlags;
+
 		if (vFlags & TTFRRW_PROCESSING_FLAG_VERBOSE_PROFILER)
 		{
 			printf("Profiler Started\n");
@@ -831,47 +3145,156 @@ bool TTFRRW::TTFRRW::Parse_Font_File(MemoryStream* vMem, const ttfrrwProcessingF
 
 		if (Parse_Table_Header(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF))
 		{
+			// access hints for mapped streams
+			// glyf is read glyph after glyph, the others are small and read soon
+			for (const auto& tbl : m_Tables)
+			{
+				vMem->Advise(tbl.second.offset, tbl.second.length, 
+					(tbl.first == "glyf") ? MemoryStream::ACCESS_HINT_SEQUENTIAL : MemoryStream::ACCESS_HINT_WILLNEED);
+			}
+
+			if (vFlags & TTFRRW_PROCESSING_FLAG_LAZY_PARSING)
+			{
+				// the tables will be parsed by the getters, see EnsureTable
+				m_IsLazy = true;
+				m_LazyFlags = vFlags;
+				res = true;
+				return res;
+			}
+
 			const bool maxpOK = Parse_MAXP_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
 			if (maxpOK) // dependencies
 			{
-				/*bool cmapOK =*/ Parse_CMAP_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
-				const bool headOK = Parse_HEAD_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
-				const bool locaOK = Parse_LOCA_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
-				const bool hheaOK = Parse_HHEA_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
-				const bool nameOK = Parse_NAME_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+				bool headOK = false;
+				bool locaOK = false;
+				bool hheaOK = false;
 				bool glyfOK = false;
-				//bool postOK = false;
 				bool hmtxOK = false;
-				bool colrOK = false;
 				bool cpalOK = false;
 
-				// on fait post avant glyf comme ca 
-				// on pourra mettre le nom directement dans le glyph
-				/*postOK = */Parse_POST_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+				// each task read with its own cursor on the font bytes
+				const uint8_t* datas = vMem->GetDatas();
+				const size_t size = vMem->GetSize();
+				auto parse = [this, datas, size, &vFlags, vWorking, vProgress, vObjectCount](ParseFunc vFunc) -> bool
+				{
+					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					MemoryStream cursor;
+					cursor.BorrowDatas(datas, size);
+					return (this->*vFunc)(&cursor, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
+				};
 
-				if (headOK && locaOK) // dependencies
-					glyfOK = Parse_GLYF_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+				// in a collection, the tables at the same offset than in a previous face are copied
+				const TTFRRW* glyfFace = nullptr;
 
+				// only the real dependencies are kept, the other tables are parsed concurrently
+				TaskGraph graph;
+				/*const size_t cmapTask =*/ graph.AddTask([&]() 
+				{
+					const TTFRRW* face = GetSharedFace({ "cmap" });
+					if (face)
+					{
+						// read only, so shared
+						m_CodePoint_To_GlyphIndex = face->m_CodePoint_To_GlyphIndex;
+						m_VariationSequences = face->m_VariationSequences;
+						m_GlyphIndex_To_CodePoints = face->m_GlyphIndex_To_CodePoints;
+					}
+					else
+					{
+						parse(&TTFRRW::Parse_CMAP_Table);
+					}
+				});
+				/*const size_t nameTask =*/ graph.AddTask([&]() { parse(&TTFRRW::Parse_NAME_Table); });
+				const size_t headTask = graph.AddTask([&]() { headOK = parse(&TTFRRW::Parse_HEAD_Table); });
+				const size_t hheaTask = graph.AddTask([&]() { hheaOK = parse(&TTFRRW::Parse_HHEA_Table); });
+				const size_t cpalTask = graph.AddTask([&]() { cpalOK = parse(&TTFRRW::Parse_CPAL_Table); });
+				// on fait post avant glyf comme ca 
+				// on pourra mettre le nom directement dans le glyph
+				const size_t postTask = graph.AddTask([&]() 
+				{ 
+					const TTFRRW* face = GetSharedFace({ "post" });
+					if (face)
+						m_GlyphNames = face->m_GlyphNames;
+					else
+						/*postOK = */parse(&TTFRRW::Parse_POST_Table); 
+				});
+				// la loca a besoin du format de la head
+				const size_t locaTask = graph.AddTask([&]() 
+				{ 
+					const TTFRRW* face = GetSharedFace({ "loca" });
+					if (face && !face->m_GlyphsOffsets->empty() &&
+						face->m_IndexToLocFormat == m_IndexToLocFormat &&
+						face->m_TTFInfos.m_GlyphCount == m_TTFInfos.m_GlyphCount)
+					{
+						m_GlyphsOffsets = face->m_GlyphsOffsets;
+						locaOK = true;
+					}
+					else
+					{
+						locaOK = parse(&TTFRRW::Parse_LOCA_Table);
+					}
+				}, { headTask });
+				const size_t glyfTask = graph.AddTask([&]() 
+				{
+					if (headOK && locaOK) // dependencies
+					{
+						// the glyphs of the face come with there metrics and colors, 
+						// so the hmtx and COLR tables are parsed again if they differ
+						glyfFace = GetSharedFace({ "glyf", "loca", "post" });
+						if (glyfFace && glyfFace->m_IsValid_For_GlyphTreatment &&
+							glyfFace->m_IndexToLocFormat == m_IndexToLocFormat &&
+							glyfFace->m_TTFInfos.m_GlyphCount == m_TTFInfos.m_GlyphCount)
+						{
+							// the glyphs point on the outlines of the other face, kept alive by m_Outlines
+							// the glyphs are copied, not shared, the hmtx and COLR tables of this face can write in them
+							m_Glyphs.clear();
+							m_Glyphs.reserve(glyfFace->m_Glyphs.size());
+							for (const auto& glyph : glyfFace->m_Glyphs)
+							{
+								m_Glyphs.emplace_back(glyph, m_GlyphAllocators); // counted in this face
+							}
+							m_Outlines = glyfFace->m_Outlines;
+							glyfOK = true;
+						}
+						else
+						{
+							glyfFace = nullptr;
+							glyfOK = parse(&TTFRRW::Parse_GLYF_Table);
+						}
+					}
+				}, { locaTask, postTask });
 				// on fait ca apres glyph comme ca on pourra remplir
 				// les metrics dans le glyph
-				if (hheaOK) // dependencies
+				graph.AddTask([&]()
 				{
-					hmtxOK = Parse_HMTX_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				}
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+					if (glyfFace && HasSameTables(glyfFace, { "hhea", "hmtx" }))
+						hmtxOK = glyfFace->m_IsValid_For_Rasterize; // copied with the glyphs
+					else if (hheaOK) // dependencies
+						hmtxOK = parse(&TTFRRW::Parse_HMTX_Table);
+				}, { hheaTask, glyfTask });
+				// hmtx and colr write different members of the glyphs
+				graph.AddTask([&]()
+				{
+					if (glyfFace)
+					{
+						if (HasSameTables(glyfFace, { "CPAL", "COLR" }))
+							return; // copied with the glyphs
 
-				cpalOK = Parse_CPAL_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+						// the layers of the other face must not stay
+						for (auto& glyph : m_Glyphs)
+						{
+							glyph.m_Color.clear();
+							glyph.m_PaletteIndex.clear();
+							glyph.m_IsLayer = false;
+							glyph.m_Layers.clear();
+							glyph.m_Parents.clear();
+						}
+					}
 
-				if (cpalOK) // dependencies
-					colrOK = Parse_COLR_Table(vMem, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
+					if (cpalOK) // dependencies
+						/*colrOK =*/ parse(&TTFRRW::Parse_COLR_Table);
+				}, { cpalTask, glyfTask });
+
+				graph.Run(ThreadPool::Instance(), m_ThreadCount);
 				ATOMIC_RETURN_IF_STOP_WORKING(false);
 
 				// tres permissif, le minimum est d'avoir des glyphs
@@ -886,21 +3309,184 @@ bool TTFRRW::TTFRRW::Parse_Font_File(MemoryStream* vMem, const ttfrrwProcessingF
 		{
 			LogError(vFlags, "ERR : Corrupted Header Table\n");
 		}
-
-		m_TTFProfiler.Print(vFlags);
 	}
 
 	return res;
 }
 
+bool TTFRRW::TTFRRW::EnsureTable(const LazyTable& vTable)
+{
+	if (!m_IsLazy) // all is parsed at open
+		return true;
+
+	return m_LazyTables[vTable].Ensure([this, &vTable]() -> bool
+	{
+		TTFRRW_ZONE_TABLE;
+
+		// same dependencies than in Parse_Font_File
+		ParseFunc func = nullptr;
+		bool dependenciesOK = true;
+		switch (vTable)
+		{
+		case LAZY_TABLE_MAXP: func = &TTFRRW::Parse_MAXP_Table; break;
+		case LAZY_TABLE_HEAD: func = &TTFRRW::Parse_HEAD_Table; break;
+		case LAZY_TABLE_HHEA: func = &TTFRRW::Parse_HHEA_Table; break;
+		case LAZY_TABLE_CMAP: func = &TTFRRW::Parse_CMAP_Table; break;
+		case LAZY_TABLE_NAME: func = &TTFRRW::Parse_NAME_Table; break;
+		case LAZY_TABLE_CPAL: func = &TTFRRW::Parse_CPAL_Table; break;
+		case LAZY_TABLE_POST:
+			dependenciesOK = EnsureTable(LAZY_TABLE_MAXP);
+			func = &TTFRRW::Parse_POST_Table;
+			break;
+		case LAZY_TABLE_LOCA:
+			dependenciesOK = EnsureTable(LAZY_TABLE_MAXP) && EnsureTable(LAZY_TABLE_HEAD);
+			func = &TTFRRW::Parse_LOCA_Table;
+			break;
+		case LAZY_TABLE_GLYF:
+			EnsureTable(LAZY_TABLE_POST); // glyph names, not mandatory
+			dependenciesOK = EnsureTable(LAZY_TABLE_LOCA);
+			func = &TTFRRW::Parse_GLYF_Table;
+			break;
+		case LAZY_TABLE_HMTX:
+			dependenciesOK = EnsureTable(LAZY_TABLE_HHEA) && EnsureTable(LAZY_TABLE_GLYF);
+			func = &TTFRRW::Parse_HMTX_Table;
+			break;
+		case LAZY_TABLE_COLR:
+			dependenciesOK = EnsureTable(LAZY_TABLE_CPAL) && EnsureTable(LAZY_TABLE_GLYF);
+			func = &TTFRRW::Parse_COLR_Table;
+			break;
+		default:
+			break;
+		}
+
+		if (!dependenciesOK || !func)
+			return false;
+
+		MemoryStream cursor;
+		cursor.BorrowDatas(m_FontStream.GetDatas(), m_FontStream.GetSize());
+		return (this->*func)(&cursor, m_LazyFlags, nullptr, nullptr, nullptr);
+	});
+}
+
+bool TTFRRW::TTFRRW::EnsureGlyphs()
+{
+	if (!m_IsLazy)
+		return m_IsValid_For_GlyphTreatment;
+
+	const bool glyfOK = EnsureTable(LAZY_TABLE_GLYF);
+	EnsureTable(LAZY_TABLE_HMTX);
+	EnsureTable(LAZY_TABLE_COLR);
+	return glyfOK;
+}
+
+TTFRRW::GlyphOutline TTFRRW::TTFRRW::EnsureGlyphOutline(const GlyphIndex& vGlyphIndex)
+{
+	GlyphOutline outline;
+	if (!m_IsGlyphsOnDemand)
+		return outline;
+
+	TTFRRW_ZONE_GLYPH;
+
+	outline.m_Glyph = &m_Glyphs[vGlyphIndex];
+
+	std::unique_lock<std::mutex> lock(m_GlyphCache.mutex);
+
+	auto it = m_GlyphCache.entries.find(vGlyphIndex);
+	if (it != m_GlyphCache.entries.end())
+	{
+		// already decoded, become the most recently used
+		m_GlyphCache.lru.splice(m_GlyphCache.lru.begin(), m_GlyphCache.lru, it->second.lru);
+	}
+	else
+	{
+		GlyphCache::Entry entry;
+		const auto& glyph = m_Glyphs[vGlyphIndex];
+		if (glyph.m_IsSimple && m_Tables.find("glyf") != m_Tables.end())
+		{
+			const auto& tbl = m_Tables.at("glyf");
+
+			MemoryStream cursor;
+			cursor.BorrowDatas(m_FontStream.GetDatas(), m_FontStream.GetSize());
+
+			// only the outline is taken, the metrics are already filled by the hmtx and colr tables
+			// the glyphs of m_Glyphs are not modified, they are read without lock
+			const AllocatorHooks outlinesHooks = GetCountedHooks(MEMORY_CATEGORY_OUTLINES);
+			auto outlines = std::allocate_shared<OutlineStore>(HookAllocator<OutlineStore>(outlinesHooks), outlinesHooks);
+			OutlineCursor outlineCursor;
+			TTFProfiler profiler;
+			auto decoded = Parse_Glyph(&cursor, tbl.offset, vGlyphIndex, outlines.get(), &outlineCursor, &profiler, m_GlyphsFlags, nullptr, nullptr, nullptr);
+			m_TTFProfiler.Merge(profiler, TimingRegistry::ROOT_NODE);
+			if (decoded.m_Outlines)
+			{
+				entry.firstContour = decoded.m_FirstContour;
+				entry.contoursCount = decoded.m_ContoursCount;
+			}
+			entry.bytes = outlines->GetMemorySize();
+			entry.outlines = outlines;
+		}
+
+		m_GlyphCache.lru.push_front(vGlyphIndex);
+		entry.lru = m_GlyphCache.lru.begin();
+		m_GlyphCache.size += entry.bytes;
+		it = m_GlyphCache.entries.insert(std::make_pair(vGlyphIndex, std::move(entry))).first;
+	}
+
+	outline.m_Outlines = it->second.outlines;
+	outline.m_FirstContour = it->second.firstContour;
+	outline.m_ContoursCount = it->second.contoursCount;
+
+	// the view keep the outline, even if it is evicted now
+	TrimGlyphCache();
+
+	return outline;
+}
+
+// m_GlyphCache.mutex must be locked
+void TTFRRW::TTFRRW::TrimGlyphCache()
+{
+	if (!m_GlyphCache.budget)
+		return;
+
+	while (m_GlyphCache.size > m_GlyphCache.budget && !m_GlyphCache.lru.empty())
+	{
+		auto it = m_GlyphCache.entries.find(m_GlyphCache.lru.back());
+		m_GlyphCache.size -= it->second.bytes;
+		m_GlyphCache.entries.erase(it); // the outline is freed with its last view
+		m_GlyphCache.lru.pop_back();
+	}
+}
+
 bool TTFRRW::TTFRRW::Parse_Table_Header(MemoryStream* vMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_Table_Header");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes header");
 
 	// header
-	const std::string scalerType = vMem->ReadString(4); //-V112
+	std::string scalerType = vMem->ReadString(4); //-V112
+	m_FacesCount = 1U;
+	if (scalerType == "ttcf") // collection, the tables offsets are from the start of the file
+	{
+		/*uint16_t majorVersion =*/ //(uint16_t)vMem->ReadUShort();
+		/*uint16_t minorVersion =*/ //(uint16_t)vMem->ReadUShort();
+		const uint32_t numFonts = (uint32_t)vMem->ReadULong(4); //-V112
+		m_FacesCount = (size_t)numFonts;
+		if (m_FaceIndex >= m_FacesCount)
+		{
+			LogError(vFlags, "ERR : Face %u not found, the collection have %u faces\n", (uint32_t)m_FaceIndex, numFonts);
+			return false;
+		}
+
+		vMem->SetPos(12U + 4U * m_FaceIndex); // offsets table, after the ttc header //-V112
+		const size_t faceOffset = (size_t)vMem->ReadULong(); //-V112
+		vMem->SetPos(faceOffset);
+		scalerType = vMem->ReadString(4); //-V112
+		LogInfos(vFlags, "Collection of %u faces, face %u at %u\n", numFonts, (uint32_t)m_FaceIndex, (uint32_t)faceOffset);
+	}
+	if (scalerType.size() < 4U) //-V112
+		return false;
 	if (scalerType[0] == 1)  m_FontType = "TrueType 1"; // TrueType 1
 	if (scalerType[1] == 1)  m_FontType = "OpenType 1"; // TrueType 1
 	const uint16_t numTables = (uint16_t)vMem->ReadUShort();
@@ -918,21 +3504,128 @@ bool TTFRRW::TTFRRW::Parse_Table_Header(MemoryStream* vMem, const ttfrrwProcessi
 		tbl.offset = (size_t)vMem->ReadULong(6);
 		tbl.length = (size_t)vMem->ReadULong(6);
 
-		m_Tables[tbl.tag] = tbl;
-		LogInfos(vFlags, "Table %s found\n", tbl.tag.c_str()); //-V111
+		m_Tables[tbl.tag] = tbl;
+		LogInfos(vFlags, "Table %s found\n", tbl.tag.c_str()); //-V111
+
+		ATOMIC_OBJECTS_COUNT_INC;
+		ATOMIC_RETURN_IF_STOP_WORKING(false);
+	}
+
+	return (!m_Tables.empty());
+}
+
+bool TTFRRW::TTFRRW::HasSameTables(const TTFRRW* vFace, const std::vector<std::string>& vTags) const
+{
+	if (!vFace)
+		return false;
+
+	for (const auto& tag : vTags)
+	{
+		const auto mine = m_Tables.find(tag);
+		const auto other = vFace->m_Tables.find(tag);
+		const bool mineFound = (mine != m_Tables.end());
+		const bool otherFound = (other != vFace->m_Tables.end());
+		if (mineFound != otherFound)
+			return false;
+		if (mineFound &&
+			(mine->second.offset != other->second.offset ||
+			mine->second.length != other->second.length))
+			return false;
+	}
+
+	return true;
+}
+
+const TTFRRW::TTFRRW* TTFRRW::TTFRRW::GetSharedFace(const std::vector<std::string>& vTags) const
+{
+	for (const auto& face : m_SharedFaces)
+	{
+		// a lazy face have maybe not parsed its tables
+		if (face && !face->m_IsLazy && HasSameTables(face, vTags))
+			return face;
+	}
+
+	return nullptr;
+}
+
+// cmap format 14, the variation sequences
+void TTFRRW::TTFRRW::Parse_CMAP_Variations(MemoryStream* vMem, const size_t& vSubtableOffset, VariationSequenceTable* vOutVariations, const ttfrrwProcessingFlags& vFlags)
+{
+	(void)vFlags; // only for the info logs
+
+	TTFRRW_ZONE_TABLE;
+
+	/*uint16_t format =*/ //(uint16_t)vMem->ReadUShort();
+	/*uint32_t length =*/ //(uint32_t)vMem->ReadULong();
+	vMem->SetPos(vSubtableOffset + 6U);
+	const size_t recordSize = 11U;
+	const size_t numVarSelectorRecords = mini((size_t)vMem->ReadULong(), vMem->GetSize() / recordSize);
+
+	for (size_t recordID = 0; recordID < numVarSelectorRecords; recordID++)
+	{
+		vMem->SetPos(vSubtableOffset + 10U + recordSize * recordID);
+		const CodePoint varSelector = (CodePoint)vMem->ReadUInt24();
+		const size_t defaultUVSOffset = (size_t)vMem->ReadULong();
+		const size_t nonDefaultUVSOffset = (size_t)vMem->ReadULong();
+
+		vOutVariations->AddSelector(varSelector);
+
+		if (defaultUVSOffset)
+		{
+			// ranges of codepoints who use there default glyph
+			vMem->SetPos(vSubtableOffset + defaultUVSOffset);
+			const size_t numUnicodeValueRanges = mini((size_t)vMem->ReadULong(), vMem->GetSize() / 4U);
+			for (size_t rangeID = 0; rangeID < numUnicodeValueRanges; rangeID++)
+			{
+				const CodePoint startUnicodeValue = (CodePoint)vMem->ReadUInt24();
+				const CodePoint additionalCount = (CodePoint)vMem->ReadByte();
+				vOutVariations->AddDefaultRange(startUnicodeValue, startUnicodeValue + additionalCount);
+			}
+		}
+
+		if (nonDefaultUVSOffset)
+		{
+			// codepoints who use a specific glyph
+			vMem->SetPos(vSubtableOffset + nonDefaultUVSOffset);
+			const size_t numUVSMappings = mini((size_t)vMem->ReadULong(), vMem->GetSize() / 5U);
+			for (size_t mappingID = 0; mappingID < numUVSMappings; mappingID++)
+			{
+				const CodePoint unicodeValue = (CodePoint)vMem->ReadUInt24();
+				const GlyphIndex glyphID = (GlyphIndex)vMem->ReadUShort();
+				vOutVariations->AddGlyph(unicodeValue, glyphID);
+			}
+		}
 
-		ATOMIC_OBJECTS_COUNT_INC;
-		ATOMIC_RETURN_IF_STOP_WORKING(false);
+		LogInfos(vFlags, "Variation selector %u\n", varSelector);
 	}
+}
 
-	return (!m_Tables.empty());
+// rank of a cmap encoding record, the best one is parsed, 0 if the format is not supported
+// the format 14 (variation sequences) is not ranked, it complete the best subtable
+static int GetCMAPSubtableRank(const uint16_t& vPlatformID, const uint16_t& vEncodingID, const uint16_t& vFormat)
+{
+	if (vFormat != 0U && vFormat != 4U && vFormat != 6U && vFormat != 12U && vFormat != 13U) //-V112
+		return 0;
+	if (vPlatformID == 3U && vEncodingID == 10U) // windows unicode full
+		return 6;
+	if (vPlatformID == 0U && (vEncodingID == 4U || vEncodingID == 6U)) // unicode full
+		return 5;
+	if (vPlatformID == 3U && vEncodingID == 1U) // windows unicode BMP
+		return 4;
+	if (vPlatformID == 0U && vEncodingID <= 3U) // unicode BMP
+		return 3;
+	if (vPlatformID == 3U && vEncodingID == 0U) // windows symbol
+		return 2;
+	return 1; // mac roman and the others
 }
 
 bool TTFRRW::TTFRRW::Parse_CMAP_Table(MemoryStream* vMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_CMAP_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes cmap");
 
 	if (!vMem) return false;
 
@@ -940,203 +3633,245 @@ bool TTFRRW::TTFRRW::Parse_CMAP_Table(MemoryStream* vMem, const ttfrrwProcessing
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 
-		const auto tbl = m_Tables["cmap"];
+		const auto& tbl = m_Tables.at("cmap");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
 		/*uint16_t version =*/ //(uint16_t)vMem->ReadUShort();
 		const uint16_t numEncodingRecords = (uint16_t)vMem->ReadUShort(2);
 
+		// only the best subtable is parsed, 
+		// so the records who point on the same subtable are parsed once
+		int bestRank = 0;
+		size_t bestOffset = 0U;
+		size_t variationsOffset = 0U;
+		uint16_t format = 0U;
 		size_t sizeOfEncodingRecord = 8U;
 		for (size_t encodingRecordID = 0; encodingRecordID < (size_t)numEncodingRecords; encodingRecordID++)
 		{
-			ATOMIC_RETURN_IF_STOP_WORKING(false);
-
 			vMem->SetPos(tbl.offset + (size_t)4U + sizeOfEncodingRecord * encodingRecordID); //-V112
 
-			/*uint16_t platformID =*/ //(uint16_t)vMem->ReadUShort();
-			/*uint16_t encodingID =*/ //(uint16_t)vMem->ReadUShort();
-			const size_t offset = (size_t)vMem->ReadULong(4);
+			const uint16_t platformID = (uint16_t)vMem->ReadUShort();
+			const uint16_t encodingID = (uint16_t)vMem->ReadUShort();
+			const size_t offset = (size_t)vMem->ReadULong();
 
 			vMem->SetPos(tbl.offset + offset);
+			const uint16_t recordFormat = (uint16_t)vMem->ReadUShort();
 
-			const uint16_t format = (uint16_t)vMem->ReadUShort();
-			
-			if (format == 0U)
+			const int rank = GetCMAPSubtableRank(platformID, encodingID, recordFormat);
+			if (rank > bestRank)
 			{
-				/*uint16_t length =*/ //(uint16_t)vMem->ReadUShort();
-				/*uint16_t language =*/ //(uint16_t)vMem->ReadUShort();
-				for (GlyphIndex glyphIndex = 0; glyphIndex < 256; glyphIndex++)
-				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+				bestRank = rank;
+				bestOffset = offset;
+				format = recordFormat;
+			}
+			else if (recordFormat == 14U && platformID == 0U && encodingID == 5U)
+			{
+				variationsOffset = offset;
+			}
+			else if (!rank)
+			{
+				LogError(vFlags, "ERR : CMAP Format %u not supported for the moment\n", recordFormat);
+			}
+		}
 
-					const uint8_t codePoint = vMem->ReadByte(4);
-					m_CodePoint_To_GlyphIndex[codePoint] = glyphIndex;
-					m_GlyphIndex_To_CodePoints[glyphIndex].emplace(codePoint);
-				}
-			} //-V112
-			else if (format == 4U) //-V112
+		if (!bestRank)
+		{
+			LogError(vFlags, "ERR : CMAP no supported subtable found\n");
+			return true;
+		}
+
+		const size_t subtableOffset = tbl.offset + bestOffset;
+
+		// built apart and set at the end, the tables of the other faces are not touched
+		const AllocatorHooks cmapHooks = GetCountedHooks(MEMORY_CATEGORY_CMAP);
+		auto codePointToGlyphIndex = std::make_shared<CodePointTable>(cmapHooks);
+
+		const std::string formatName = "format" + std::to_string(format);
+		TimingScope formatTiming(&m_TTFProfiler.timings, timing.GetNode(), formatName.c_str());
+
+		if (format == 0U)
+		{
+			/*uint16_t length =*/ //(uint16_t)vMem->ReadUShort();
+			/*uint16_t language =*/ //(uint16_t)vMem->ReadUShort();
+			vMem->SetPos(subtableOffset + 6U);
+			const std::vector<uint8_t> glyphIdArray = vMem->ReadBytes(256U);
+			for (size_t codePoint = 0; codePoint < glyphIdArray.size(); codePoint++)
 			{
-				/*uint16_t length =*/ //(uint16_t)vMem->ReadUShort();
-				/*uint16_t language =*/ //(uint16_t)vMem->ReadUShort();
-				const uint16_t segCountX2 = (uint16_t)vMem->ReadUShort(4);
-				/*uint16_t searchRange =*/ //(uint16_t)vMem->ReadUShort();
-				/*uint16_t entrySelector =*/ //(uint16_t)vMem->ReadUShort();
-				/*uint16_t rangeShift =*/ //(uint16_t)vMem->ReadUShort();
-
-				std::vector<uint16_t> endCode;
-				std::vector<uint16_t> startCode;
-				std::vector<int16_t> idDelta;
-				std::vector<uint16_t> idRangeOffset;
-
-				int segCount = segCountX2 / 2;
-				for (int i = 0; i < segCount; i++)
+				const GlyphIndex glyphIndex = glyphIdArray[codePoint];
+				if (glyphIndex)
 				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
-
-					endCode.push_back((uint16_t)vMem->ReadUShort(10));
+					codePointToGlyphIndex->Set((CodePoint)codePoint, glyphIndex);
 				}
-				/*uint16_t reservedPad =*/ //(uint16_t)vMem->ReadUShort();
-				for (int i = 0; i < segCount; i++)
-				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+			}
+		} //-V112
+		else if (format == 4U) //-V112
+		{
+			/*uint16_t length =*/ //(uint16_t)vMem->ReadUShort();
+			/*uint16_t language =*/ //(uint16_t)vMem->ReadUShort();
+			vMem->SetPos(subtableOffset + 6U);
+			const uint16_t segCountX2 = (uint16_t)vMem->ReadUShort();
+			/*uint16_t searchRange =*/ //(uint16_t)vMem->ReadUShort();
+			/*uint16_t entrySelector =*/ //(uint16_t)vMem->ReadUShort();
+			/*uint16_t rangeShift =*/ //(uint16_t)vMem->ReadUShort();
+
+			const size_t segCount = segCountX2 / 2U;
+
+			std::vector<uint16_t> endCode(segCount);
+			std::vector<uint16_t> startCode(segCount);
+			std::vector<int16_t> idDelta(segCount);
+			std::vector<uint16_t> idRangeOffset(segCount);
+
+			const size_t endCodeAddress = subtableOffset + 14U;
+			/*uint16_t reservedPad =*/ //(uint16_t)vMem->ReadUShort();
+			const size_t startCodeAddress = endCodeAddress + segCountX2 + 2U;
+			const size_t idDeltaAddress = startCodeAddress + segCountX2;
+			const size_t idRangeOffsetAddress = idDeltaAddress + segCountX2;
+
+			vMem->SetPos(endCodeAddress);
+			vMem->ReadUShortArray(endCode.data(), endCode.size());
+			vMem->SetPos(startCodeAddress);
+			vMem->ReadUShortArray(startCode.data(), startCode.size());
+			vMem->SetPos(idDeltaAddress);
+			vMem->ReadShortArray(idDelta.data(), idDelta.size());
+			vMem->SetPos(idRangeOffsetAddress);
+			vMem->ReadUShortArray(idRangeOffset.data(), idRangeOffset.size());
+
+			// each segment is walked on its range of codepoints
+			std::vector<uint16_t> glyphIdArray;
+			for (size_t segment = 0; segment < segCount; segment++)
+			{
+				ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-					startCode.push_back((uint16_t)vMem->ReadUShort(12));
-				}
-				for (int i = 0; i < segCount; i++)
+				const size_t start = startCode[segment];
+				const size_t end = endCode[segment];
+				if (start > end)
 				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
-
-					idDelta.push_back((uint16_t)vMem->ReadShort(12));
+					LogError(vFlags, "ERR : CMAP segment %u : start %u > end %u\n", (uint32_t)segment, (uint32_t)start, (uint32_t)end);
+					continue;
 				}
-				const size_t idRangeOffsetAddress = vMem->GetPos() + 12;
-				for (int i = 0; i < segCount; i++)
-				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-					idRangeOffset.push_back((uint16_t)vMem->ReadUShort(12));
+				const size_t count = end - start + 1U;
+				const size_t delta = (size_t)(uint16_t)idDelta[segment];
+				const size_t id_range_offset = (size_t)idRangeOffset[segment];
+				if (id_range_offset)
+				{
+					// the glyph ids of the segment are after the idRangeOffset of the segment
+					glyphIdArray.resize(count);
+					vMem->SetPos(idRangeOffsetAddress + segment * sizeof(uint16_t) + id_range_offset);
+					vMem->ReadUShortArray(glyphIdArray.data(), count);
 				}
 
-				for (uint16_t codePoint = 0; codePoint < 0xFFFF; codePoint++) //-V112
+				for (size_t idx = 0; idx < count; idx++)
 				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					const size_t codePoint = start + idx;
+					if (codePoint == 0xFFFFU) // end of the table
+						break;
 
-					// d'abord on va localiser le segment
-					bool found = false;
-					size_t segment = 0;
-					size_t start = 0;
-					size_t end = segCount;
-					while (start != end)
+					GlyphIndex glyphIndex = 0;
+					if (!id_range_offset)
 					{
-						segment = (start + end) / 2;
-						if (codePoint < startCode[segment])  // location is below current location
-							end = segment;
-						else  // is key below the upper bound?
-						{
-							if (codePoint <= endCode[segment])
-							{
-								found = true;
-								break;
-							}
-							// location is above the current location
-							start = segment + 1;
-						}
+						glyphIndex = (GlyphIndex)((codePoint + delta) & 0xFFFFU); // modulo 65536
 					}
-					if (found)
+					else if (glyphIdArray[idx])
 					{
-						start = startCode[segment];
-						if (codePoint >= start)
-						{
-							GlyphIndex foundGlyphIndex = 0;
-
-							const size_t id_range_offset = (size_t)idRangeOffset[segment];
-							if (id_range_offset == 0)
-							{
-								foundGlyphIndex = (codePoint + idDelta[segment]) % 0x10000; // 0x10000 is 65536
-							}
-							else
-							{
-								const size_t idRangeOffsetLocation = idRangeOffsetAddress + segment * sizeof(uint16_t);
-								vMem->SetPos(id_range_offset + idRangeOffsetLocation + ((size_t)codePoint - start) * 2U);
-								foundGlyphIndex = (uint16_t)vMem->ReadUShort();
-							}
+						glyphIndex = (GlyphIndex)((glyphIdArray[idx] + delta) & 0xFFFFU);
+					}
 
-							if (foundGlyphIndex < 0xFFFF)
-							{
-								m_CodePoint_To_GlyphIndex[codePoint] = foundGlyphIndex;
-								m_GlyphIndex_To_CodePoints[foundGlyphIndex].emplace(codePoint);
-								LogInfos(vFlags, "CodePoint %u => GlyphIndex %u\n", codePoint, foundGlyphIndex);
-							}
-							else
-							{
-								LogError(vFlags, "ERR : CodePoint %u => Error\n", codePoint);
-							}
-						}
-						else
-						{
-							//notdef;
-						}
+					if (glyphIndex) // 0 is .notdef, so not mapped
+					{
+						codePointToGlyphIndex->Set((CodePoint)codePoint, glyphIndex);
 					}
 				}
+
+				LogInfos(vFlags, "CodePoints %u-%u => segment %u\n", (uint32_t)start, (uint32_t)end, (uint32_t)segment);
 			}
-			else if (format == 6U)
+		}
+		else if (format == 6U)
+		{
+			/*uint16_t length =*/ //(uint16_t)vMem->ReadUShort();
+			/*uint16_t language =*/ //(uint16_t)vMem->ReadUShort();
+			vMem->SetPos(subtableOffset + 6U);
+			const uint16_t firstCode = (uint16_t)vMem->ReadUShort();
+			const uint16_t entryCount = (uint16_t)vMem->ReadUShort();
+			std::vector<uint16_t> glyphIdArray(entryCount);
+			vMem->ReadUShortArray(glyphIdArray.data(), glyphIdArray.size());
+			for (size_t idx = 0; idx < (size_t)entryCount; idx++)
 			{
-				/*uint16_t length =*/ //(uint16_t)vMem->ReadUShort();
-				/*uint16_t language =*/ //(uint16_t)vMem->ReadUShort();
-				const uint16_t firstCode = (uint16_t)vMem->ReadUShort(4);
-				const uint16_t entryCount = (uint16_t)vMem->ReadUShort(4);
-				for (GlyphIndex glyphIndex = 0; glyphIndex < entryCount; glyphIndex++)
+				const size_t codePoint = (size_t)firstCode + idx;
+				const GlyphIndex glyphIndex = glyphIdArray[idx];
+				if (glyphIndex && codePoint < 0xFFFFU)
 				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
-
-					const uint16_t codePoint = (uint16_t)vMem->ReadUShort(4);
-					m_CodePoint_To_GlyphIndex[codePoint] = glyphIndex;
-					m_GlyphIndex_To_CodePoints[glyphIndex].emplace(codePoint);
+					codePointToGlyphIndex->Set((CodePoint)codePoint, glyphIndex);
 				}
 			}
-			else if (format == 12)
+		}
+		else if (format == 12U || format == 13U)
+		{
+			/*uint16_t reserved =*/ //(uint16_t)vMem->ReadUShort();
+			/*uint32_t length =*/ //(uint32_t)vMem->ReadULong();
+			/*uint32_t language =*/ //(uint32_t)vMem->ReadULong();
+			vMem->SetPos(subtableOffset + 12U);
+			const size_t groupsSize = 12U;
+			const size_t nGroups = mini((size_t)vMem->ReadULong(), (vMem->GetSize() - mini(vMem->GetPos(), vMem->GetSize())) / groupsSize);
+			
+			for (size_t groupID = 0; groupID < nGroups; groupID++)
 			{
-				/*uint16_t reserved =*/ //(uint16_t)vMem->ReadUShort();
-				/*uint32_t length =*/ //(uint32_t)vMem->ReadULong();
-				/*uint32_t language =*/ //(uint32_t)vMem->ReadULong();
-				const uint32_t nGroups = (uint32_t)vMem->ReadULong(10);
-				
-				for (uint32_t groupID = 0; groupID < nGroups; groupID++)
-				{
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+				ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-					const uint32_t startCharCode = (uint32_t)vMem->ReadULong(10);
-					const uint32_t endCharCode = (uint32_t)vMem->ReadULong(10);
-					const uint32_t startGlyphID = (uint32_t)vMem->ReadULong(10);
+				const CodePoint startCharCode = (CodePoint)vMem->ReadULong();
+				const CodePoint endCharCode = mini((CodePoint)vMem->ReadULong(), MAX_CODEPOINT);
+				const uint32_t startGlyphID = (uint32_t)vMem->ReadULong();
+
+				if (startCharCode > endCharCode)
+				{
+					LogError(vFlags, "ERR : CMAP group %u : start %u > end %u\n", (uint32_t)groupID, startCharCode, endCharCode);
+					continue;
+				}
 
-					const uint32_t count = endCharCode - startCharCode;
-					if (count)
+				if (format == 13U)
+				{
+					// many to one, kept as a range
+					codePointToGlyphIndex->AddRange(startCharCode, endCharCode, (GlyphIndex)startGlyphID);
+				}
+				else
+				{
+					// the end is included
+					const uint32_t count = endCharCode - startCharCode + 1U;
+					for (uint32_t charCodeID = 0; charCodeID < count; charCodeID++)
 					{
-						for (uint32_t charCodeID = 0; charCodeID < count; charCodeID++)
+						const CodePoint codePoint = startCharCode + charCodeID;
+						const GlyphIndex glyphIndex = (GlyphIndex)(startGlyphID + charCodeID);
+						if (glyphIndex)
 						{
-							ATOMIC_RETURN_IF_STOP_WORKING(false);
-
-							const CodePoint codePoint = (CodePoint)(startCharCode + charCodeID);
-							const GlyphIndex glyphIndex = (GlyphIndex)(startGlyphID + charCodeID);
-							m_CodePoint_To_GlyphIndex[codePoint] = glyphIndex;
-							m_GlyphIndex_To_CodePoints[glyphIndex].emplace(codePoint);
+							codePointToGlyphIndex->Set(codePoint, glyphIndex);
 						}
 					}
-					else
-					{
-						const CodePoint codePoint = (CodePoint)startCharCode;
-						const GlyphIndex glyphIndex = (GlyphIndex)startGlyphID;
-						m_CodePoint_To_GlyphIndex[codePoint] = glyphIndex;
-						m_GlyphIndex_To_CodePoints[glyphIndex].emplace(codePoint);
-					}
 				}
 			}
-			else
+
+			if (format == 13U)
 			{
-				LogError(vFlags, "ERR : CMAP Format %u not supported for the moment\n", format);
+				codePointToGlyphIndex->SortRanges();
 			}
 		}
 
+		formatTiming.Stop();
+
+		auto glyphIndexToCodePoints = std::make_shared<GlyphCodePointsTable>(cmapHooks);
+		glyphIndexToCodePoints->Build(*codePointToGlyphIndex);
+
+		auto variationSequences = std::make_shared<VariationSequenceTable>(cmapHooks);
+		if (variationsOffset)
+		{
+			TimingScope variationsTiming(&m_TTFProfiler.timings, timing.GetNode(), "format14");
+			Parse_CMAP_Variations(vMem, tbl.offset + variationsOffset, variationSequences.get(), vFlags);
+		}
+
+		m_CodePoint_To_GlyphIndex = codePointToGlyphIndex;
+		m_VariationSequences = variationSequences;
+		m_GlyphIndex_To_CodePoints = glyphIndexToCodePoints;
+
 		return true;
 	}
 	else
@@ -1151,14 +3886,16 @@ bool TTFRRW::TTFRRW::Parse_HEAD_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_HEAD_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes head");
 
 	if (m_Tables.find("head") != m_Tables.end())
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["head"];
+		const auto& tbl = m_Tables.at("head");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
@@ -1194,22 +3931,28 @@ bool TTFRRW::TTFRRW::Parse_MAXP_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_MAXP_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes maxp");
 
 	if (m_Tables.find("maxp") != m_Tables.end())
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["maxp"];
+		const auto& tbl = m_Tables.at("maxp");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
-		/*MemoryStream::Fixed version =*/ //vMem->ReadFixed();
-		m_TTFInfos.m_GlyphCount = (uint16_t)vMem->ReadUShort(4);
-		/*uint16_t maxPoints = (uint16_t)vMem->ReadUShort();
-		uint16_t maxContours = (uint16_t)vMem->ReadUShort();
-		uint16_t maxComponentPoints = (uint16_t)vMem->ReadUShort();
+		const uint32_t version = (uint32_t)vMem->ReadULong();
+		m_TTFInfos.m_GlyphCount = (uint16_t)vMem->ReadUShort();
+		if (version == 0x00010000) // the 0.5 version of the CFF fonts have only the glyph count
+		{
+			// used for size the buffers of the glyf parsing
+			m_TTFInfos.m_MaxPoints = (uint16_t)vMem->ReadUShort();
+			m_TTFInfos.m_MaxContours = (uint16_t)vMem->ReadUShort();
+		}
+		/*uint16_t maxComponentPoints = (uint16_t)vMem->ReadUShort();
 		uint16_t maxComponentContours = (uint16_t)vMem->ReadUShort();
 		uint16_t maxZones = (uint16_t)vMem->ReadUShort();
 		uint16_t maxTwilightPoints = (uint16_t)vMem->ReadUShort();
@@ -1235,39 +3978,43 @@ bool TTFRRW::TTFRRW::Parse_LOCA_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_LOCA_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes loca");
 
 	if (m_Tables.find("loca") != m_Tables.end())
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["loca"];
+		const auto& tbl = m_Tables.at("loca");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
-		m_GlyphsOffsets.resize((size_t)m_TTFInfos.m_GlyphCount);
+		const size_t glyphCount = (size_t)m_TTFInfos.m_GlyphCount;
+		auto glyphsOffsets = std::make_shared<GlyphsOffsets>(glyphCount, 0U, HookAllocator<size_t>(GetCountedHooks(MEMORY_CATEGORY_LOCA)));
 
 		if (m_IndexToLocFormat == 0) // short format
 		{
-			for (uint16_t i = 0; i < m_TTFInfos.m_GlyphCount; i++)
+			std::vector<uint16_t> offsets(glyphCount);
+			vMem->ReadUShortArray(offsets.data(), offsets.size());
+			for (size_t i = 0; i < glyphCount; i++)
 			{
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
-
-				const size_t offset = (size_t)((uint32_t)vMem->ReadUShort()) * 2;
-				m_GlyphsOffsets[i] = offset;
+				(*glyphsOffsets)[i] = (size_t)offsets[i] * 2U;
 			}
 		}
 		else if (m_IndexToLocFormat == 1) // long format
 		{
-			for (uint16_t i = 0; i < m_TTFInfos.m_GlyphCount; i++)
+			std::vector<uint32_t> offsets(glyphCount);
+			vMem->ReadULongArray(offsets.data(), offsets.size());
+			for (size_t i = 0; i < glyphCount; i++)
 			{
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
-
-				const size_t offset = (size_t)((uint32_t)vMem->ReadULong());
-				m_GlyphsOffsets[i] = offset;
+				(*glyphsOffsets)[i] = (size_t)offsets[i];
 			}
 		}
+		ATOMIC_RETURN_IF_STOP_WORKING(false);
+
+		m_GlyphsOffsets = glyphsOffsets;
 
 		return true;
 	}
@@ -1276,292 +4023,636 @@ bool TTFRRW::TTFRRW::Parse_LOCA_Table(MemoryStream* vMem, const ttfrrwProcessing
 		LogError(vFlags, "ERR : LOCA Table not found\n");
 	}
 
-	return false;
+	return false;
+}
+
+// glyphs count decoded in one range by a worker
+#define GLYF_PARSING_GRAIN 64U
+
+static void ReserveSimpleGlyfScratch(const size_t& vMaxPoints); // see SIMPLE GLYF DECODER
+
+bool TTFRRW::TTFRRW::Parse_GLYF_Table(MemoryStream* vMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
+{
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_GLYF_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes glyf");
+
+	if (m_Tables.find("glyf") != m_Tables.end())
+	{
+		ATOMIC_OBJECTS_COUNT_INC;
+		ATOMIC_RETURN_IF_STOP_WORKING(false);
+
+		const auto& tbl = m_Tables.at("glyf");
+		//uint32_t len = tbl.length;
+
+		// the glyphs are independents, thanks to the loca offsets
+		// so each worker decode a range of glyphs with its own read cursor
+		const size_t glyphCount = (size_t)m_TTFInfos.m_GlyphCount;
+		m_Glyphs.clear();
+		m_Glyphs.resize(glyphCount, Glyph(m_GlyphAllocators));
+
+		// in on demand mode, only bbox and type are read here
+		const ttfrrwProcessingFlags glyphFlags = m_IsGlyphsOnDemand ? 
+			(vFlags | TTFRRW_PROCESSING_FLAG_NO_GLYPH_PARSING) : vFlags;
+
+		// the outlines are bump allocated in the font store
+		// a first pass count the points and contours of each range, for know where each range write
+		const size_t rangesCount = (glyphCount + GLYF_PARSING_GRAIN - 1U) / GLYF_PARSING_GRAIN;
+		std::vector<OutlineCursor> rangesCursors(rangesCount);
+		if (!m_Outlines)
+		{
+			const AllocatorHooks outlinesHooks = GetCountedHooks(MEMORY_CATEGORY_OUTLINES);
+			m_Outlines = std::allocate_shared<OutlineStore>(HookAllocator<OutlineStore>(outlinesHooks), outlinesHooks);
+		}
+#ifdef TRACY_ENABLE
+		const auto decodeStart = std::chrono::steady_clock::now();
+#endif
+		if (!(glyphFlags & TTFRRW_PROCESSING_FLAG_NO_GLYPH_PARSING))
+		{
+			ThreadPool::Instance()->ParallelFor(glyphCount, GLYF_PARSING_GRAIN,
+				[&](const size_t& vBegin, const size_t& vEnd)
+			{
+				TTFRRW_PLOT_TABLE_RANGE_BYTES;
+
+				MemoryStream cursor;
+				cursor.BorrowDatas(vMem->GetDatas(), vMem->GetSize());
+				for (size_t glyphID = vBegin; glyphID < vEnd; glyphID++)
+				{
+					const auto counts = Count_Glyph_Outline(&cursor, tbl.offset, (GlyphIndex)glyphID);
+					auto& range = rangesCursors[glyphID / GLYF_PARSING_GRAIN];
+					range.contour += counts.contour;
+					range.point += counts.point;
+				}
+			}, m_ThreadCount);
+
+			// counts => starts
+			OutlineCursor total;
+			for (auto& range : rangesCursors)
+			{
+				const OutlineCursor counts = range;
+				range = total;
+				total.contour += counts.contour;
+				total.point += counts.point;
+			}
+			m_Outlines->Resize(total.point, total.contour);
+		}
+
+		std::atomic<uint32_t> glyphsDone(0U);
+		std::atomic<bool> stopped(false);
+		if (vProgress)
+			vProgress->store(0.0f, std::memory_order_relaxed);
+
+		ThreadPool::Instance()->ParallelFor(glyphCount, GLYF_PARSING_GRAIN, 
+			[&](const size_t& vBegin, const size_t& vEnd)
+		{
+			TTFRRW_ZONE_TABLE;
+			TTFRRW_PLOT_TABLE_RANGE_BYTES;
+
+			MemoryStream cursor;
+			cursor.BorrowDatas(vMem->GetDatas(), vMem->GetSize());
+			TTFProfiler profiler;
+			ProgressCounter counter(vObjectCount, vProgress, &glyphsDone, glyphCount);
+
+			// the ranges are contiguous in the store, so a cursor can continue on the next ranges
+			OutlineCursor outlineCursor = rangesCursors[vBegin / GLYF_PARSING_GRAIN];
+			ReserveSimpleGlyfScratch((size_t)m_TTFInfos.m_MaxPoints);
+
+			for (size_t glyphID = vBegin; glyphID < vEnd; glyphID++)
+			{
+				// checked for each glyph, the points of a glyph are not checked
+				if (stopped.load(std::memory_order_relaxed) || (vWorking && !vWorking->load(std::memory_order_relaxed)))
+				{
+					stopped.store(true, std::memory_order_relaxed);
+					break;
+				}
+
+				m_Glyphs[glyphID] = Parse_Glyph(&cursor, tbl.offset, (GlyphIndex)glyphID, m_Outlines.get(), &outlineCursor, &profiler, glyphFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
+
+				counter.Add();
+			}
+
+			// the glyphs timings are nested in the table, added once per range
+			m_TTFProfiler.Merge(profiler, timing.GetNode());
+		}, m_ThreadCount);
+
+		// the counters of the threads are published at the end of there ranges, so the final progress is exact
+		if (vProgress && glyphCount)
+			vProgress->store((float)glyphsDone.load() / (float)glyphCount);
+
+#ifdef TRACY_ENABLE
+		const double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+		if (decodeSeconds > 0.0)
+			TracyPlot("TTFRRW glyphs/s", (double)glyphsDone.load() / decodeSeconds);
+#endif
+
+		return !stopped.load();
+	}
+	else
+	{
+		LogError(vFlags, "ERR : GLYF Table not found\n");
+	}
+
+	return false;
+}
+
+TTFRRW::Glyph TTFRRW::TTFRRW::Parse_Glyph(MemoryStream* vMem, const size_t& vGlyfOffset, const GlyphIndex& vGlyphIndex, OutlineStore* vOutlines, OutlineCursor* vCursor, TTFProfiler* vProfiler, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
+{
+	TTFRRW_ZONE_GLYPH;
+	// one scope per glyph, accumulated in the profiler of the range without lock
+	TimingScope timing(vProfiler ? &vProfiler->glyphs : nullptr);
+
+	Glyph glyph(m_GlyphAllocators);
+
+	const size_t glyphID = (size_t)vGlyphIndex;
+	if (glyphID < m_GlyphsOffsets->size())
+	{
+		const size_t glyphOffset = vGlyfOffset + (*m_GlyphsOffsets)[glyphID];
+		vMem->SetPos(glyphOffset);
+
+		const int16_t numberOfContours = (int16_t)vMem->ReadShort();
+		const MemoryStream::FWord xMin = vMem->ReadFWord();
+		const MemoryStream::FWord yMin = vMem->ReadFWord();
+		const MemoryStream::FWord xMax = vMem->ReadFWord();
+		const MemoryStream::FWord yMax = vMem->ReadFWord();
+
+		LogInfos(vFlags, "-----------------------\n");
+
+		glyph.m_LocalBBox.lowerBound.x = xMin;
+		glyph.m_LocalBBox.lowerBound.y = yMin;
+		glyph.m_LocalBBox.upperBound.x = xMax;
+		glyph.m_LocalBBox.upperBound.y = yMax;
+
+		if (glyphID < m_GlyphNames->size())
+			glyph.m_Name = (*m_GlyphNames)[glyphID];
+
+		LogInfos(vFlags, "BBox : %i,%i > %i,%i\n", xMin, yMin, xMax, yMax);
+
+		if (numberOfContours >= 0) // simple glyf
+		{
+			LogInfos(vFlags, "Glyph %u : Simple Glyph\n", (uint32_t)glyphID);
+
+			glyph.m_IsSimple = true;
+
+			if (!(vFlags & TTFRRW_PROCESSING_FLAG_NO_GLYPH_PARSING))
+			{
+				// the contours are written in vOutlines at vCursor
+				Parse_Simple_Glyf(vMem, vGlyphIndex, numberOfContours, vOutlines, vCursor, &glyph, vProfiler, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
+			}
+		}
+		else // composite glyf
+		{
+			LogInfos(vFlags, "Glyph %u : Composite Glyph\n", (uint32_t)glyphID);
+
+			glyph.m_IsSimple = false;
+		}
+
+		LogInfos(vFlags, "-----------------------\n");
+	}
+
+	return glyph;
+}
+
+TTFRRW::OutlineCursor TTFRRW::TTFRRW::Count_Glyph_Outline(MemoryStream* vMem, const size_t& vGlyfOffset, const GlyphIndex& vGlyphIndex)
+{
+	OutlineCursor counts;
+
+	const size_t glyphID = (size_t)vGlyphIndex;
+	if (glyphID < m_GlyphsOffsets->size())
+	{
+		vMem->SetPos(vGlyfOffset + (*m_GlyphsOffsets)[glyphID]);
+
+		const int16_t numberOfContours = (int16_t)vMem->ReadShort();
+		if (numberOfContours >= 0) // simple glyf
+		{
+			vMem->SetPos(vMem->GetPos() + 8U); // bbox
+
+			// same rule than Parse_Simple_Glyf for the ends
+			uint32_t lastEnd = 0U;
+			for (int16_t contourID = 0; contourID < numberOfContours; contourID++)
+			{
+				const uint32_t end = (uint32_t)vMem->ReadUShort() + 1U;
+				if (end > lastEnd)
+					lastEnd = end;
+			}
+
+			counts.contour = (size_t)numberOfContours;
+			counts.point = (size_t)lastEnd;
+		}
+	}
+
+	return counts;
+}
+
+///////////////////////////////////////////////////////////////////////
+//// SIMPLE GLYF DECODER //////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+enum SimpleFlags
+{
+	SimpleFlagOnCurve = 1 << 0,
+	SimpleFlagOnXShort = 1 << 1,
+	SimpleFlagOnYShort = 1 << 2,
+	SimpleFlagOnRepeat = 1 << 3,
+	SimpleFlagOnXRepeatSign = 1 << 4,
+	SimpleFlagOnYRepeatSign = 1 << 5,
+};
+
+// reference decoder, byte after byte, the simd decoder must give the same results
+// read vCount flags, x and y coordinates, the coordinates are absolutes
+void TTFRRW::DecodeSimpleGlyfPoints_Scalar(MemoryStream* vMem, const size_t& vCount, uint8_t* vFlags, int16_t* vXCoords, int16_t* vYCoords)
+{
+	uint32_t flag_repeat = 0;
+	int32_t flag = 0;
+	for (size_t pointID = 0; pointID < vCount; pointID++)
+	{
+		if (flag_repeat == 0)
+		{
+			flag = vMem->ReadByte();
+			if ((flag & SimpleFlagOnRepeat) == SimpleFlagOnRepeat)
+			{
+				flag_repeat = vMem->ReadByte();
+			}
+		}
+		else
+		{
+			flag_repeat--;
+		}
+
+		vFlags[pointID] = (uint8_t)flag;
+	}
+
+	for (size_t pointID = 0; pointID < vCount; pointID++)
+	{
+		flag = vFlags[pointID];
+
+		vXCoords[pointID] = 0;
+		if ((flag & SimpleFlagOnXShort) == SimpleFlagOnXShort)
+		{
+			int16_t coord = (int16_t)vMem->ReadByte();
+			coord *= ((flag & SimpleFlagOnXRepeatSign) == SimpleFlagOnXRepeatSign) ? 1 : -1;
+			vXCoords[pointID] = coord;
+		}
+		else if (!((flag & SimpleFlagOnXRepeatSign) == SimpleFlagOnXRepeatSign))
+		{
+			vXCoords[pointID] = (int16_t)vMem->ReadShort();
+		}
+		if (pointID)
+		{
+			vXCoords[pointID] += vXCoords[pointID - 1U];
+		}
+	}
+
+	for (size_t pointID = 0; pointID < vCount; pointID++)
+	{
+		flag = vFlags[pointID];
+
+		vYCoords[pointID] = 0;
+		if ((flag & SimpleFlagOnYShort) == SimpleFlagOnYShort)
+		{
+			int16_t coord = (int16_t)vMem->ReadByte();
+			coord *= ((flag & SimpleFlagOnYRepeatSign) == SimpleFlagOnYRepeatSign) ? 1 : -1;
+			vYCoords[pointID] = coord;
+		}
+		else if (!((flag & SimpleFlagOnYRepeatSign) == SimpleFlagOnYRepeatSign))
+		{
+			vYCoords[pointID] = (int16_t)vMem->ReadShort();
+		}
+		if (pointID)
+		{
+			vYCoords[pointID] += vYCoords[pointID - 1U];
+		}
+	}
+}
+
+static inline uint32_t CountTrailingZeros(const uint32_t& v) // v != 0
+{
+#if defined(_MSC_VER)
+	unsigned long idx = 0;
+	_BitScanForward(&idx, v);
+	return (uint32_t)idx;
+#else
+	return (uint32_t)__builtin_ctz(v);
+#endif
+}
+
+// expand the repeated flags, copy by blocks of 16 flags when there is no repeat
+// return the count of bytes consumed, or 0 if the stream is too short
+static size_t ExpandSimpleGlyfFlags(const uint8_t* vSrc, const size_t& vSize, const size_t& vCount, uint8_t* vFlags)
+{
+	size_t pointID = 0;
+	size_t pos = 0;
+	while (pointID < vCount)
+	{
+#ifdef USE_SIMD_SSE2
+		if (pointID + 16U <= vCount && pos + 16U <= vSize)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(vSrc + pos));
+			const __m128i repeatBit = _mm_set1_epi8(SimpleFlagOnRepeat);
+			const uint32_t repeatMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, repeatBit), repeatBit));
+			if (repeatMask == 0U) // no repeat in the block
+			{
+				_mm_storeu_si128((__m128i*)(vFlags + pointID), v);
+				pointID += 16U;
+				pos += 16U;
+				continue;
+			}
+
+			// copy the flags before the first repeat
+			const size_t len = (size_t)CountTrailingZeros(repeatMask);
+			if (len)
+			{
+				memcpy(vFlags + pointID, vSrc + pos, len);
+				pointID += len;
+				pos += len;
+			}
+		}
+#endif
+		if (pos >= vSize)
+			return 0;
+
+		const uint8_t flag = vSrc[pos++];
+		vFlags[pointID++] = flag;
+		if ((flag & SimpleFlagOnRepeat) == SimpleFlagOnRepeat)
+		{
+			if (pos >= vSize)
+				return 0;
+
+			const size_t repeat = TTFRRW::mini((size_t)vSrc[pos++], vCount - pointID);
+			memset(vFlags + pointID, flag, repeat);
+			pointID += repeat;
+		}
+	}
+
+	return pos;
 }
 
-bool TTFRRW::TTFRRW::Parse_GLYF_Table(MemoryStream* vMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
+// byte width of each delta, from the flags
+// short => 1, same (or positive short) => 0, else 2
+static void ComputeDeltaWidths(const uint8_t* vFlags, const size_t& vCount, const uint8_t& vShortBit, const uint8_t& vSameBit, uint8_t* vWidths)
 {
-	(void)vProgress;
-
-	ZoneScoped;
-
-	if (m_Tables.find("glyf") != m_Tables.end())
+	size_t idx = 0;
+#ifdef USE_SIMD_SSE2
+	const __m128i shortBit = _mm_set1_epi8((char)vShortBit);
+	const __m128i sameBit = _mm_set1_epi8((char)vSameBit);
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i two = _mm_set1_epi8(2);
+	for (; idx + 16U <= vCount; idx += 16U)
 	{
-		ATOMIC_OBJECTS_COUNT_INC;
-		ATOMIC_RETURN_IF_STOP_WORKING(false);
-
-		auto tbl = m_Tables["glyf"];
-		vMem->SetPos(tbl.offset);
-		//uint32_t len = tbl.length;
+		const __m128i f = _mm_loadu_si128((const __m128i*)(vFlags + idx));
+		const __m128i isShort = _mm_cmpeq_epi8(_mm_and_si128(f, shortBit), shortBit);
+		const __m128i isSame = _mm_cmpeq_epi8(_mm_and_si128(f, sameBit), sameBit);
+		const __m128i w = _mm_or_si128(
+			_mm_and_si128(isShort, one),
+			_mm_andnot_si128(_mm_or_si128(isShort, isSame), two));
+		_mm_storeu_si128((__m128i*)(vWidths + idx), w);
+	}
+#endif
+	for (; idx < vCount; idx++)
+	{
+		const uint8_t f = vFlags[idx];
+		vWidths[idx] = (f & vShortBit) ? 1U : ((f & vSameBit) ? 0U : 2U);
+	}
+}
 
-		//size_t length = 0;
-		for (size_t glyphID = 0; glyphID < (size_t)m_TTFInfos.m_GlyphCount; glyphID++)
-		{
-			if (vProgress)
-				vProgress->store((float)glyphID / (float)m_TTFInfos.m_GlyphCount);
+// exclusive prefix sum of the widths => byte offset of each delta
+// return the total byte count
+static size_t ComputeDeltaOffsets(const uint8_t* vWidths, const size_t& vCount, uint32_t* vOffsets)
+{
+	size_t idx = 0;
+	uint32_t run = 0;
+#ifdef USE_SIMD_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	__m128i carry = zero;
+	for (; idx + 4U <= vCount; idx += 4U)
+	{
+		int32_t packed = 0;
+		memcpy(&packed, vWidths + idx, 4U); //-V112
+		const __m128i w = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+		__m128i x = _mm_add_epi32(w, _mm_slli_si128(w, 4)); //-V112
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi32(x, carry); // inclusive
+		_mm_storeu_si128((__m128i*)(vOffsets + idx), _mm_sub_epi32(x, w)); // exclusive
+		carry = _mm_shuffle_epi32(x, 0xFF);
+	}
+	run = (uint32_t)_mm_cvtsi128_si32(carry);
+#endif
+	for (; idx < vCount; idx++)
+	{
+		vOffsets[idx] = run;
+		run += vWidths[idx];
+	}
+	return (size_t)run;
+}
 
-			ATOMIC_OBJECTS_COUNT_INC;
-			ATOMIC_RETURN_IF_STOP_WORKING(false);
+// gather the deltas at there offsets, branchless
+// the 2 bytes at each offset are read, whatever the width
+// so vSrc must be readable until the byte count of the deltas + 2 (last offset + 1 with a last width of 0)
+static void GatherDeltas(const uint8_t* vSrc, const uint8_t* vFlags, const uint8_t* vWidths, const uint32_t* vOffsets, 
+	const size_t& vCount, const uint8_t& vSameBit, int16_t* vDeltas)
+{
+	for (size_t idx = 0; idx < vCount; idx++)
+	{
+		const uint8_t* p = vSrc + vOffsets[idx];
+		const int32_t b0 = p[0];
+		const int32_t b1 = p[1];
+		const int32_t shortDelta = (vFlags[idx] & vSameBit) ? b0 : -b0;
+		const int32_t longDelta = (int16_t)((b0 << 8) | b1);
+		const uint8_t w = vWidths[idx];
+		vDeltas[idx] = (int16_t)((w == 1U) ? shortDelta : ((w == 2U) ? longDelta : 0));
+	}
+}
 
-			const size_t glyphOffset = tbl.offset + m_GlyphsOffsets[glyphID];
-			vMem->SetPos(glyphOffset);
+// inclusive prefix sum of the deltas => absolute coords
+// int16 wrap around like the scalar decoder
+static void PrefixSumCoords(int16_t* vCoords, const size_t& vCount)
+{
+	size_t idx = 0;
+	int16_t run = 0;
+#ifdef USE_SIMD_SSE2
+	__m128i carry = _mm_setzero_si128();
+	for (; idx + 8U <= vCount; idx += 8U)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(vCoords + idx));
+		x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+		x = _mm_add_epi16(x, _mm_slli_si128(x, 4)); //-V112
+		x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi16(x, carry);
+		_mm_storeu_si128((__m128i*)(vCoords + idx), x);
+		carry = _mm_shufflehi_epi16(x, 0xFF); // broadcast of the last lane
+		carry = _mm_unpackhi_epi64(carry, carry);
+	}
+	run = (int16_t)_mm_extract_epi16(carry, 0);
+#endif
+	for (; idx < vCount; idx++)
+	{
+		run = (int16_t)(run + vCoords[idx]);
+		vCoords[idx] = run;
+	}
+}
 
-			const int16_t numberOfContours = (int16_t)vMem->ReadShort();
-			const MemoryStream::FWord xMin = vMem->ReadFWord();
-			const MemoryStream::FWord yMin = vMem->ReadFWord();
-			const MemoryStream::FWord xMax = vMem->ReadFWord();
-			const MemoryStream::FWord yMax = vMem->ReadFWord();
+// scratch buffers of the simd decoder, one per thread, reused from glyph to glyph and from font to font
+struct SimpleGlyfScratch
+{
+	std::vector<uint8_t> widths;
+	std::vector<uint32_t> offsets;
+};
 
-			LogInfos(vFlags, "-----------------------\n");
+static SimpleGlyfScratch& GetSimpleGlyfScratch()
+{
+	static thread_local SimpleGlyfScratch _scratch;
+	return _scratch;
+}
 
-			Glyph glyph;
-			glyph.m_LocalBBox.lowerBound.x = xMin;
-			glyph.m_LocalBBox.lowerBound.y = yMin;
-			glyph.m_LocalBBox.upperBound.x = xMax;
-			glyph.m_LocalBBox.upperBound.y = yMax;
+// sized once with the maxPoints of the maxp table, before the glyphs of a range
+static void ReserveSimpleGlyfScratch(const size_t& vMaxPoints)
+{
+	auto& scratch = GetSimpleGlyfScratch();
+	if (scratch.widths.size() < vMaxPoints)
+	{
+		scratch.widths.resize(vMaxPoints);
+		scratch.offsets.resize(vMaxPoints);
+	}
+}
 
-			if (glyphID < m_GlyphNames.size())
-				glyph.m_Name = m_GlyphNames[glyphID];
+// vectorized decoder, work on the raw bytes of the stream
+// return false if the stream is too short, nothing is consumed in this case
+bool TTFRRW::DecodeSimpleGlyfPoints_Simd(MemoryStream* vMem, const size_t& vCount, uint8_t* vFlags, int16_t* vXCoords, int16_t* vYCoords)
+{
+	const size_t start = vMem->GetPos();
+	const size_t size = vMem->GetSize();
+	if (start >= size)
+		return false;
 
-			LogInfos(vFlags, "BBox : %i,%i > %i,%i\n", xMin, yMin, xMax, yMax);
+	const uint8_t* src = vMem->GetDatas() + start;
+	const size_t available = size - start;
 
-			if (numberOfContours >= 0) // simple glyf
-			{
-				LogInfos(vFlags, "Glyph %u : Simple Glyph\n", (uint32_t)glyphID);
+	const size_t flagsSize = ExpandSimpleGlyfFlags(src, available, vCount, vFlags);
+	if (!flagsSize)
+		return false;
 
-				glyph.m_IsSimple = true;
+	// scratch, one per thread, sized from maxp by ReserveSimpleGlyfScratch
+	auto& scratch = GetSimpleGlyfScratch();
+	if (scratch.widths.size() < vCount) // maxp can lie
+	{
+		scratch.widths.resize(vCount);
+		scratch.offsets.resize(vCount);
+	}
+	auto& widths = scratch.widths;
+	auto& offsets = scratch.offsets;
 
-				if (!(vFlags & TTFRRW_PROCESSING_FLAG_NO_GLYPH_PARSING))
-				{
-					const auto g = Parse_Simple_Glyf(vMem, (GlyphIndex)glyphID, numberOfContours, vFlags, TTFRRW_ATOMIC_PARAMS_BY_REF);
-					glyph.m_Contours = g.m_Contours;
-					glyph.m_AdvanceX = g.m_AdvanceX;
-					glyph.m_LeftSideBearing = g.m_LeftSideBearing;
-				}
-			}
-			else // composite glyf
-			{
-				LogInfos(vFlags, "Glyph %u : Composite Glyph\n", (uint32_t)glyphID);
+	ComputeDeltaWidths(vFlags, vCount, SimpleFlagOnXShort, SimpleFlagOnXRepeatSign, widths.data());
+	const size_t xSize = ComputeDeltaOffsets(widths.data(), vCount, offsets.data());
+	// + 2 since the gather read always 2 bytes, even at the offset of a last delta of 0 byte
+	if (flagsSize + xSize + 2U > available)
+		return false;
+	GatherDeltas(src + flagsSize, vFlags, widths.data(), offsets.data(), vCount, SimpleFlagOnXRepeatSign, vXCoords);
 
-				glyph.m_IsSimple = false;
-			}
+	ComputeDeltaWidths(vFlags, vCount, SimpleFlagOnYShort, SimpleFlagOnYRepeatSign, widths.data());
+	const size_t ySize = ComputeDeltaOffsets(widths.data(), vCount, offsets.data());
+	if (flagsSize + xSize + ySize + 2U > available)
+		return false;
+	GatherDeltas(src + flagsSize + xSize, vFlags, widths.data(), offsets.data(), vCount, SimpleFlagOnYRepeatSign, vYCoords);
 
-			m_Glyphs.push_back(glyph);
+	PrefixSumCoords(vXCoords, vCount);
+	PrefixSumCoords(vYCoords, vCount);
 
-			LogInfos(vFlags, "-----------------------\n");
+	vMem->SetPos(start + flagsSize + xSize + ySize);
+	TTFRRW_COUNT_READ_BYTES(flagsSize + xSize + ySize);
 
-		//	length = glyphOffset;
-		}
+	return true;
+}
 
-		return true;
-	}
-	else
+// decode vCount points : flags and absolutes coords
+static void DecodeSimpleGlyfPoints(TTFRRW::MemoryStream* vMem, const size_t& vCount, uint8_t* vFlags, int16_t* vXCoords, int16_t* vYCoords)
+{
+	if (!TTFRRW::DecodeSimpleGlyfPoints_Simd(vMem, vCount, vFlags, vXCoords, vYCoords))
 	{
-		LogError(vFlags, "ERR : GLYF Table not found\n");
+		// truncated glyph, the scalar decoder give 0 for the missing bytes
+		TTFRRW::DecodeSimpleGlyfPoints_Scalar(vMem, vCount, vFlags, vXCoords, vYCoords);
 	}
-
-	return false;
 }
 
-TTFRRW::Glyph TTFRRW::TTFRRW::Parse_Simple_Glyf(MemoryStream* vMem, const GlyphIndex& vGlyphIndex, const int16_t& vCountContour, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
+bool TTFRRW::TTFRRW::Parse_Simple_Glyf(MemoryStream* vMem, const GlyphIndex& vGlyphIndex, const int16_t& vCountContour, OutlineStore* vOutlines, OutlineCursor* vCursor, Glyph* vOutGlyph, TTFProfiler* vProfiler, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS)
 {
+	(void)vWorking;
 	(void)vProgress;
 	(void)vObjectCount;
+	(void)vProfiler; // the glyph is measured in Parse_Glyph
 
-	ZoneScoped;
+	TTFRRW_ZONE_GLYPH;
 
-	Glyph glyph;
+	bool res = false;
 
-	if (vMem)
+	if (vMem && vOutlines && vCursor && vOutGlyph)
 	{
-#ifdef USE_SIMPLE_PROFILER
-		m_TTFProfiler.simpleGlyfProfiler.start();
-#endif
 		if (vCountContour >= 0) // this is well simple glyph
 		{
 			const size_t countContours = (size_t)vCountContour;
 
-#ifdef USE_STL_CLASSES
-			std::vector<uint16_t> endPtsOfContours; // todo: to use a std::deque say PVS => to check
-			endPtsOfContours.resize(countContours);
-#else
-			uint16_t* endPtsOfContours = new uint16_t[countContours];
-			memset(endPtsOfContours, 0, sizeof(uint16_t) * countContours);
-#endif
+			// the glyph is written at the cursor
+			// the store is sized by Count_Glyph_Outline before, else it grow here (glyph alone in its store)
+			const size_t firstContour = vCursor->contour;
+			const size_t firstPoint = vCursor->point;
+
+			// endPtsOfContours, directly as ends in the store
+			if (vOutlines->m_ContourEnds.size() < firstContour + countContours)
+				vOutlines->m_ContourEnds.resize(firstContour + countContours);
+			uint32_t* contourEnds = vOutlines->m_ContourEnds.data() + firstContour;
+			uint32_t lastEnd = 0U;
 			for (size_t contourID = 0; contourID < countContours; contourID++)
 			{
-				endPtsOfContours[contourID] = (uint16_t)vMem->ReadShort() + 1U;
-			}
-
-			const size_t instructionLength = (size_t)vMem->ReadUShort();
-			if (instructionLength)
-			{	
-#ifdef USE_STL_CLASSES
-				std::vector<uint8_t> instructions;
-				instructions.resize(instructionLength);
-#else
-				uint8_t* instructions = new uint8_t[instructionLength];
-				memset(instructions, 0, sizeof(uint8_t) * instructionLength);
-#endif
-				for (size_t instructionID = 0; instructionID < instructionLength; instructionID++)
+				uint32_t end = (uint32_t)vMem->ReadUShort() + 1U;
+				if (end <= lastEnd)
 				{
-					instructions[instructionID] = (uint8_t)vMem->ReadByte();
+					LogError(vFlags, "ERR : Point count is null in Contour %u of glyph %u\n", (uint32_t)contourID, vGlyphIndex);
+					end = lastEnd; // empty contour, the ends must grow
 				}
-				delete[] instructions;
+				contourEnds[contourID] = end;
+				lastEnd = end;
 			}
 
-#ifdef USE_STL_CLASSES
-			std::vector<uint8_t> flags;
-			std::vector<bool> onCurves;
-			std::vector<int16_t> xCoordinates;
-			std::vector<int16_t> yCoordinates;
-#else
-			uint8_t* flags = nullptr;
-			bool* onCurves = nullptr;
-			int16_t* xCoordinates = nullptr;
-			int16_t* yCoordinates = nullptr;
-#endif
-			const size_t maxPoints = (size_t)endPtsOfContours[countContours - 1];
+			// instructions, not used
+			const size_t instructionLength = (size_t)vMem->ReadUShort();
+			vMem->SetPos(vMem->GetPos() + instructionLength);
+
+			const size_t maxPoints = (size_t)lastEnd;
 			if (maxPoints)
 			{
-#ifdef USE_STL_CLASSES
-				xCoordinates.resize(maxPoints);
-				yCoordinates.resize(maxPoints);
-				onCurves.resize(maxPoints);
-				flags.resize(maxPoints);
-#else
-				xCoordinates = new int16_t[maxPoints];
-				memset(xCoordinates, 0, sizeof(int16_t) * maxPoints);
-				yCoordinates = new int16_t[maxPoints];
-				memset(yCoordinates, 0, sizeof(int16_t) * maxPoints);
-				onCurves = new bool[maxPoints];
-				memset(onCurves, 0, sizeof(bool) * maxPoints);
-				flags = new uint8_t[maxPoints];
-				memset(flags, 0, sizeof(uint8_t) * maxPoints);
-#endif
-				enum SimpleFlags
-				{
-					SimpleFlagOnCurve = 1 << 0,
-					SimpleFlagOnXShort = 1 << 1,
-					SimpleFlagOnYShort = 1 << 2,
-					SimpleFlagOnRepeat = 1 << 3,
-					SimpleFlagOnXRepeatSign = 1 << 4,
-					SimpleFlagOnYRepeatSign = 1 << 5,
-				};
-
-				uint32_t flag_repeat = 0;
-				int32_t flag = 0;
-				for (size_t pointID = 0; pointID < maxPoints; pointID++)
-				{
-					ATOMIC_RETURN_IF_STOP_WORKING(glyph);
-
-					if (flag_repeat == 0)
-					{
-						flag = vMem->ReadByte();
-						if ((flag & SimpleFlagOnRepeat) == SimpleFlagOnRepeat)
-						{
-							flag_repeat = vMem->ReadByte();
-						}
-					}
-					else
-					{
-						flag_repeat--;
-					}
-
-					const uint8_t u8Flag = (uint8_t)flag;
-					flags[pointID] = u8Flag;
-					onCurves[pointID] = ((u8Flag & SimpleFlagOnCurve) == SimpleFlagOnCurve);
-				}
-
-				for (size_t pointID = 0; pointID < maxPoints; pointID++)
+				if (vOutlines->m_X.size() < firstPoint + maxPoints)
 				{
-					ATOMIC_RETURN_IF_STOP_WORKING(glyph);
-
-					flag = flags[pointID];
-
-					if ((flag & SimpleFlagOnXShort) == SimpleFlagOnXShort)
-					{
-						int16_t coord = (int16_t)vMem->ReadByte();
-						coord *= ((flag & SimpleFlagOnXRepeatSign) == SimpleFlagOnXRepeatSign) ? 1 : -1;
-						xCoordinates[pointID] = coord;
-					}
-					else if (!((flag & SimpleFlagOnXRepeatSign) == SimpleFlagOnXRepeatSign))
-					{
-						xCoordinates[pointID] = (int16_t)vMem->ReadShort();
-					}
-					if (pointID)
-					{
-						xCoordinates[pointID] += xCoordinates[pointID - 1U];
-					}
+					vOutlines->m_X.resize(firstPoint + maxPoints);
+					vOutlines->m_Y.resize(firstPoint + maxPoints);
+					vOutlines->m_OnCurve.resize(firstPoint + maxPoints);
 				}
 
+				// the flags are decoded in the on curve array, then reduced to the on curve bit
+				uint8_t* onCurves = vOutlines->m_OnCurve.data() + firstPoint;
+				DecodeSimpleGlyfPoints(vMem, maxPoints, onCurves,
+					vOutlines->m_X.data() + firstPoint, vOutlines->m_Y.data() + firstPoint);
 				for (size_t pointID = 0; pointID < maxPoints; pointID++)
 				{
-					ATOMIC_RETURN_IF_STOP_WORKING(glyph);
-
-					flag = flags[pointID];
-
-					if ((flag & SimpleFlagOnYShort) == SimpleFlagOnYShort)
-					{
-						int16_t coord = (int16_t)vMem->ReadByte();
-						coord *= ((flag & SimpleFlagOnYRepeatSign) == SimpleFlagOnYRepeatSign) ? 1 : -1;
-						yCoordinates[pointID] = coord;
-					}
-					else if (!((flag & SimpleFlagOnYRepeatSign) == SimpleFlagOnYRepeatSign))
-					{
-						yCoordinates[pointID] = (int16_t)vMem->ReadShort();
-					}
-					if (pointID)
-					{
-						yCoordinates[pointID] += yCoordinates[pointID - 1U];
-					}
+					onCurves[pointID] &= SimpleFlagOnCurve;
 				}
 			}
 
-			// convert in final glyph
-			size_t lastCount = 0;
-			glyph.m_Contours.resize(countContours);
+			// the ends are absolutes in the store
 			for (size_t contourID = 0; contourID < countContours; contourID++)
 			{
-				ATOMIC_RETURN_IF_STOP_WORKING(glyph);
-
-				const auto contour = &glyph.m_Contours[contourID];
-				const size_t pmax = endPtsOfContours[contourID] - lastCount;
-				if (pmax)
-				{
-					contour->m_Points.resize(pmax);
-					contour->m_OnCurve.resize(pmax);
+				contourEnds[contourID] += (uint32_t)firstPoint;
+			}
 
-					for (size_t p = 0; p < pmax; p++)
-					{
-						ATOMIC_RETURN_IF_STOP_WORKING(glyph);
+			vOutGlyph->m_Outlines = vOutlines;
+			vOutGlyph->m_FirstContour = (uint32_t)firstContour;
+			vOutGlyph->m_ContoursCount = (uint32_t)countContours;
 
-						contour->m_Points[p].x = (int32_t)xCoordinates[lastCount + p];
-						contour->m_Points[p].y = (int32_t)yCoordinates[lastCount + p];
-						contour->m_OnCurve[p] = onCurves[lastCount + p];
-					}
-				}
-				else
-				{
-					LogError(vFlags, "ERR : Point count is null in Contour %u of glyph %u\n", (uint32_t)contourID, vGlyphIndex);
-				}
+			vCursor->contour += countContours;
+			vCursor->point += maxPoints;
 
-				lastCount = endPtsOfContours[contourID];
-			}
-#ifndef USE_STL_CLASSES
-			delete[] flags; flags = nullptr;
-			delete[] onCurves; onCurves = nullptr;
-			delete[] xCoordinates; xCoordinates = nullptr;
-			delete[] yCoordinates; yCoordinates = nullptr;
-			delete[] endPtsOfContours; endPtsOfContours = nullptr;
-#endif
+			res = true;
 		}
-#ifdef USE_SIMPLE_PROFILER
-		m_TTFProfiler.simpleGlyfProfiler.end();
-#endif
 	}
 
-	return glyph;
+	return res;
 }
 
 #define STANDARD_MAC_NAMES_COUNT 258
@@ -1595,17 +4686,23 @@ bool TTFRRW::TTFRRW::Parse_POST_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_POST_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes post");
+
+	ProgressCounter objectsCounter(vObjectCount);
 
 	if (m_Tables.find("post") != m_Tables.end())
 	{
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["post"];
+		const auto& tbl = m_Tables.at("post");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
-		m_GlyphNames.clear();
+		// built apart and set at the end, the names of the other faces are not touched
+		auto glyphNames = std::make_shared<GlyphNameArray>(GlyphNameArray::allocator_type(m_GlyphAllocators.names));
+		const HookAllocator<char>& nameAllocator = m_GlyphAllocators.names;
 
 		const MemoryStream::Fixed format = vMem->ReadFixed();
 		/*MemoryStream::Fixed italicAngle =*/ //vMem->ReadFixed();//4
@@ -1621,10 +4718,9 @@ bool TTFRRW::TTFRRW::Parse_POST_Table(MemoryStream* vMem, const ttfrrwProcessing
 		{
 			for (size_t idx = 0; idx < STANDARD_MAC_NAMES_COUNT; idx++)
 			{
-				ATOMIC_OBJECTS_COUNT_INC;
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+				ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
-				m_GlyphNames.push_back(standardMacNames[idx]);
+				glyphNames->emplace_back(standardMacNames[idx], nameAllocator);
 			}
 		}
 		else if (format.high == 2)
@@ -1638,8 +4734,7 @@ bool TTFRRW::TTFRRW::Parse_POST_Table(MemoryStream* vMem, const ttfrrwProcessing
 				std::vector<uint16_t> glyphNameIndex;
 				for (int i = 0; i < numberOfGlyphs; i++)
 				{
-					ATOMIC_OBJECTS_COUNT_INC;
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 					glyphNameIndex.push_back((uint16_t)vMem->ReadUShort(28));
 				}
@@ -1649,8 +4744,7 @@ bool TTFRRW::TTFRRW::Parse_POST_Table(MemoryStream* vMem, const ttfrrwProcessing
 				std::vector<std::string> pendingNames;
 				while (vMem->GetPos() < endPos)
 				{
-					ATOMIC_OBJECTS_COUNT_INC;
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 					const uint8_t len = vMem->ReadByte(28);
 					const std::string str = vMem->ReadString(len, 28);
@@ -1659,19 +4753,18 @@ bool TTFRRW::TTFRRW::Parse_POST_Table(MemoryStream* vMem, const ttfrrwProcessing
 
 				for (int i = 0; i < numberOfGlyphs; i++)
 				{
-					ATOMIC_OBJECTS_COUNT_INC;
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 					const uint16_t mapIdx = glyphNameIndex[i];
 					if (mapIdx >= 258)
 					{
 						const uint16_t idx = mapIdx - 258;
 						if (idx < pendingNames.size())
-							m_GlyphNames.push_back(pendingNames[idx]);
+							glyphNames->emplace_back(pendingNames[idx].c_str(), pendingNames[idx].size(), nameAllocator);
 					}
 					else
 					{
-						m_GlyphNames.emplace_back(standardMacNames[mapIdx]);
+						glyphNames->emplace_back(standardMacNames[mapIdx], nameAllocator);
 					}
 				}
 			}
@@ -1693,6 +4786,8 @@ bool TTFRRW::TTFRRW::Parse_POST_Table(MemoryStream* vMem, const ttfrrwProcessing
 			LogError(vFlags, "ERR : POST Format %u not supported for the moment\n", format.high);
 		}
 
+		m_GlyphNames = glyphNames;
+
 		return true;
 	}
 	else
@@ -1707,13 +4802,17 @@ bool TTFRRW::TTFRRW::Parse_CPAL_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_CPAL_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes CPAL");
+
+	ProgressCounter objectsCounter(vObjectCount);
 
 	if (m_Tables.find("CPAL") != m_Tables.end())
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 
-		auto tbl = m_Tables["CPAL"];
+		const auto& tbl = m_Tables.at("CPAL");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
@@ -1729,22 +4828,19 @@ bool TTFRRW::TTFRRW::Parse_CPAL_Table(MemoryStream* vMem, const ttfrrwProcessing
 			colorRecordIndices.resize(numPalettes);
 			for (int paletteIndex = 0; paletteIndex < numPalettes; paletteIndex++)
 			{
-				ATOMIC_OBJECTS_COUNT_INC;
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+				ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 				colorRecordIndices[paletteIndex] = (uint16_t)vMem->ReadUShort(2);
 			}
 
-			m_Palettes.resize(numPalettes);
+			m_Palettes.resize(numPalettes, PaletteColors(m_Palettes.get_allocator()));
 			for (size_t paletteIndex = 0; paletteIndex < numPalettes; paletteIndex++)
 			{
-				ATOMIC_OBJECTS_COUNT_INC;
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+				ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 				for (size_t paletteEntryIndex = 0; paletteEntryIndex < numPaletteEntries; paletteEntryIndex++)
 				{
-					ATOMIC_OBJECTS_COUNT_INC;
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 					const size_t colorRecordIndex = (size_t)colorRecordIndices[paletteIndex] + paletteEntryIndex;
 
@@ -1779,13 +4875,17 @@ bool TTFRRW::TTFRRW::Parse_COLR_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_COLR_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes COLR");
+
+	ProgressCounter objectsCounter(vObjectCount);
 
 	if (m_Tables.find("COLR") != m_Tables.end())
 	{
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["COLR"];
+		const auto& tbl = m_Tables.at("COLR");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
@@ -1797,8 +4897,7 @@ bool TTFRRW::TTFRRW::Parse_COLR_Table(MemoryStream* vMem, const ttfrrwProcessing
 
 		for (size_t glyphRecordID = 0; glyphRecordID < (size_t)numBaseGlyphRecords; glyphRecordID++)
 		{
-			ATOMIC_OBJECTS_COUNT_INC;
-			ATOMIC_RETURN_IF_STOP_WORKING(false);
+			ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 			vMem->SetPos(tbl.offset + (size_t)baseGlyphRecordsOffset + glyphRecordID * 6U);
 			const uint16_t baseGlyphID = (uint16_t)vMem->ReadUShort();
@@ -1809,8 +4908,7 @@ bool TTFRRW::TTFRRW::Parse_COLR_Table(MemoryStream* vMem, const ttfrrwProcessing
 			{
 				for (size_t layerID = 0; layerID < (size_t)numLayers; layerID++)
 				{
-					ATOMIC_OBJECTS_COUNT_INC;
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 					vMem->SetPos(tbl.offset + (size_t)layerRecordsOffset + ((size_t)firstLayerIndex + layerID) * 4U); //-V112
 					const uint16_t glyphID = (uint16_t)vMem->ReadUShort();
@@ -1856,14 +4954,16 @@ bool TTFRRW::TTFRRW::Parse_HHEA_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_HHEA_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes hhea");
 
 	if (m_Tables.find("hhea") != m_Tables.end())
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["hhea"];
+		const auto& tbl = m_Tables.at("hhea");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
@@ -1901,14 +5001,18 @@ bool TTFRRW::TTFRRW::Parse_HMTX_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_HMTX_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes hmtx");
+
+	ProgressCounter objectsCounter(vObjectCount);
 
 	if (m_Tables.find("hmtx") != m_Tables.end())
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["hmtx"];
+		const auto& tbl = m_Tables.at("hmtx");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
@@ -1920,16 +5024,19 @@ bool TTFRRW::TTFRRW::Parse_HMTX_Table(MemoryStream* vMem, const ttfrrwProcessing
 				int16_t leftSideBearing = 0;
 			};
 
+			// advanceWidth, leftSideBearing pairs
+			std::vector<uint16_t> rawMetrics((size_t)m_MumOfLongHorMetrics * 2U);
+			vMem->ReadUShortArray(rawMetrics.data(), rawMetrics.size());
+
 			std::vector<longHorMetric> hMetrics;
 			hMetrics.resize(m_MumOfLongHorMetrics);
 			for (GlyphIndex glyphID = 0; glyphID < m_MumOfLongHorMetrics; glyphID++)
 			{
-				ATOMIC_OBJECTS_COUNT_INC;
-				ATOMIC_RETURN_IF_STOP_WORKING(false);
+				ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
 				longHorMetric lhm;
-				lhm.advanceWidth = (uint16_t)vMem->ReadUShort();
-				lhm.leftSideBearing = (int16_t)vMem->ReadShort();
+				lhm.advanceWidth = rawMetrics[glyphID * 2U];
+				lhm.leftSideBearing = (int16_t)rawMetrics[glyphID * 2U + 1U];
 				hMetrics[glyphID] = lhm;
 				if (glyphID < m_Glyphs.size())
 				{
@@ -1945,12 +5052,11 @@ bool TTFRRW::TTFRRW::Parse_HMTX_Table(MemoryStream* vMem, const ttfrrwProcessing
 				std::vector<MemoryStream::FWord> leftSideBearings;
 				const size_t leftSideBearingCount = (size_t)m_TTFInfos.m_GlyphCount - (size_t)m_MumOfLongHorMetrics;
 				leftSideBearings.resize(leftSideBearingCount);
+				vMem->ReadShortArray(leftSideBearings.data(), leftSideBearings.size());
 				for (GlyphIndex idx = 0; idx < leftSideBearingCount; idx++)
 				{
-					ATOMIC_OBJECTS_COUNT_INC;
-					ATOMIC_RETURN_IF_STOP_WORKING(false);
+					ATOMIC_OBJECTS_COUNT_ADD(objectsCounter, false);
 
-					leftSideBearings[idx] = vMem->ReadFWord();
 					const GlyphIndex glyphID = m_MumOfLongHorMetrics + idx;
 					if (glyphID < m_Glyphs.size())
 					{
@@ -1990,14 +5096,16 @@ bool TTFRRW::TTFRRW::Parse_NAME_Table(MemoryStream* vMem, const ttfrrwProcessing
 {
 	(void)vProgress;
 
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Parse_NAME_Table");
+	TTFRRW_PLOT_TABLE_BYTES("TTFRRW bytes name");
 
 	if (m_Tables.find("name") != m_Tables.end())
 	{
 		ATOMIC_OBJECTS_COUNT_INC;
 		ATOMIC_RETURN_IF_STOP_WORKING(false);
 
-		auto tbl = m_Tables["name"];
+		const auto& tbl = m_Tables.at("name");
 		vMem->SetPos(tbl.offset);
 		//uint32_t len = tbl.length;
 
@@ -2022,7 +5130,7 @@ bool TTFRRW::TTFRRW::Parse_NAME_Table(MemoryStream* vMem, const ttfrrwProcessing
 				vMem->SetPos(tbl.offset + storageOffset + stringOffset);
 				const std::string name = vMem->ReadString(length);
 				LogInfos(vFlags, "NameID %u => %s", nameID, name.c_str());
-				m_Names.emplace(std::pair<uint16_t, std::string>(nameID, name));
+				m_Names.emplace(nameID, HookString(name.c_str(), name.size(), m_Names.get_allocator()));
 			}
 		}
 		else
@@ -2044,7 +5152,8 @@ bool TTFRRW::TTFRRW::Parse_NAME_Table(MemoryStream* vMem, const ttfrrwProcessing
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_GLYF_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_GLYF_Table");
 
 	MemoryStream mem;
 
@@ -2053,7 +5162,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_GLYF_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_LOCA_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_LOCA_Table");
 
 	MemoryStream mem;
 
@@ -2062,7 +5172,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_LOCA_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_MAXP_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_MAXP_Table");
 
 	MemoryStream mem;
 
@@ -2071,7 +5182,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_MAXP_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_CMAP_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_CMAP_Table");
 
 	MemoryStream mem;
 
@@ -2119,7 +5231,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_CMAP_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_HMTX_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_HMTX_Table");
 
 	MemoryStream mem;
 
@@ -2128,7 +5241,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_HMTX_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_HHEA_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_HHEA_Table");
 
 	MemoryStream mem;
 
@@ -2161,7 +5275,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_HHEA_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_POST_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_POST_Table");
 
 	MemoryStream mem;
 
@@ -2188,7 +5303,7 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_POST_Table()
 	int32_t tableIndex = STANDARD_MAC_NAMES_COUNT;
 	for (size_t idx = 0; idx < m_Glyphs.size(); idx++)
 	{
-		const auto& name = m_Glyphs[idx].m_Name;
+		const std::string name(m_Glyphs[idx].m_Name.c_str(), m_Glyphs[idx].m_Name.size());
 		if (!name.empty())
 		{
 			int32_t glyphNameIndex = 0;
@@ -2212,7 +5327,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_POST_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_NAME_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_NAME_Table");
 
 	MemoryStream mem;
 
@@ -2221,7 +5337,8 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_NAME_Table()
 
 TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_HEAD_Table()
 {
-	ZoneScoped;
+	TTFRRW_ZONE_TABLE;
+	TimingScope timing(&m_TTFProfiler.timings, m_TTFProfiler.stageNode, "Assemble_HEAD_Table");
 
 	MemoryStream mem;
 
@@ -2307,3 +5424,207 @@ TTFRRW::MemoryStream TTFRRW::TTFRRW::Assemble_HEAD_Table()
 
 	return mem;
 }
+
+///////////////////////////////////////////////////////////////////////
+//// FONT BATCH ///////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+void TTFRRW::FontBatch::AddFontFile(const std::string& vFontFilePathName)
+{
+	Source source;
+	source.path = vFontFilePathName;
+	m_Sources.push_back(source);
+}
+
+void TTFRRW::FontBatch::AddFontStream(const uint8_t* vStream, const size_t& vStreamSize)
+{
+	Source source;
+	source.stream = vStream;
+	source.streamSize = vStreamSize;
+	m_Sources.push_back(source);
+}
+
+void TTFRRW::FontBatch::Clear()
+{
+	m_Sources.clear();
+	m_Fonts.clear();
+}
+
+void TTFRRW::FontBatch::SetThreadCount(const size_t& vThreadCount)
+{
+	m_ThreadCount = vThreadCount;
+}
+
+size_t TTFRRW::FontBatch::Open(ttfrrwProcessingFlags vFlags, TTFRRW_ATOMIC_PARAMS)
+{
+	TTFRRW_ZONE_API;
+
+	const size_t count = m_Sources.size();
+
+	m_Fonts.clear();
+	m_Fonts.resize(count);
+
+	if (vProgress)
+		vProgress->store(0.0f);
+	if (vObjectCount)
+		vObjectCount->store(0U);
+
+	std::atomic<size_t> fontsDone(0U);
+	std::atomic<size_t> fontsOpened(0U);
+
+	// one font per range, the glyf table of each font is a job too,
+	// so the threads without fonts to take help on the glyphs of the others
+	ThreadPool::Instance()->ParallelFor(count, 1U, [&](const size_t& vBegin, const size_t& vEnd)
+	{
+		TTFRRW_ZONE_API;
+
+		for (size_t idx = vBegin; idx < vEnd; idx++)
+		{
+			if (vWorking && !vWorking->load())
+				break;
+
+			const auto& source = m_Sources[idx];
+			std::unique_ptr<TTFRRW> font(new TTFRRW());
+			font->SetThreadCount(m_ThreadCount);
+
+			// no progress per font, else each font reset the counters of the batch
+			bool res = false;
+			if (source.stream)
+				res = font->OpenFontStream(source.stream, source.streamSize, vFlags | TTFRRW_PROCESSING_FLAG_BORROW_STREAM, "", vWorking, nullptr, vObjectCount);
+			else
+				res = font->OpenFontFile(source.path, vFlags, source.path.c_str(), vWorking, nullptr, vObjectCount);
+
+			if (res)
+			{
+				m_Fonts[idx] = std::move(font);
+				fontsOpened++;
+			}
+
+			const size_t done = ++fontsDone;
+			if (vProgress)
+				PublishProgress(vProgress, (float)done / (float)count);
+		}
+	}, m_ThreadCount);
+
+	return fontsOpened.load();
+}
+
+size_t TTFRRW::FontBatch::GetFontsCount() const
+{
+	return m_Sources.size();
+}
+
+TTFRRW::TTFRRW* TTFRRW::FontBatch::GetFont(const size_t& vIdx)
+{
+	if (vIdx < m_Fonts.size())
+		return m_Fonts[vIdx].get();
+	return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////
+//// FONT COLLECTION //////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////
+
+bool TTFRRW::FontCollection::OpenCollectionFile(
+	const std::string& vFontFilePathName,
+	ttfrrwProcessingFlags vFlags,
+	const char* vDebugInfos,
+	TTFRRW_ATOMIC_PARAMS)
+{
+	TTFRRW_ZONE_API;
+	TTFRRW_FRAME_OPEN; // the faces are in the frame of the collection
+
+	Clear();
+
+	int error = 0;
+	if (TTFRRW::LoadFileToMemory(vFontFilePathName, &m_Stream, &error))
+	{
+		return OpenFaces(vFlags, vDebugInfos, TTFRRW_ATOMIC_PARAMS_BY_REF);
+	}
+
+	return false;
+}
+
+bool TTFRRW::FontCollection::OpenCollectionStream(
+	const uint8_t* vStream, const size_t& vStreamSize,
+	ttfrrwProcessingFlags vFlags,
+	const char* vDebugInfos,
+	TTFRRW_ATOMIC_PARAMS)
+{
+	TTFRRW_ZONE_API;
+	TTFRRW_FRAME_OPEN; // the faces are in the frame of the collection
+
+	Clear();
+
+	if (vStream && vStreamSize)
+	{
+		m_Stream.BorrowDatas(vStream, vStreamSize);
+		return OpenFaces(vFlags, vDebugInfos, TTFRRW_ATOMIC_PARAMS_BY_REF);
+	}
+
+	return false;
+}
+
+void TTFRRW::FontCollection::Clear()
+{
+	// the faces first, they can read in the stream
+	m_Faces.clear();
+	m_Stream.Release();
+}
+
+size_t TTFRRW::FontCollection::GetFacesCount() const
+{
+	return m_Faces.size();
+}
+
+TTFRRW::TTFRRW* TTFRRW::FontCollection::GetFace(const size_t& vIdx)
+{
+	if (vIdx < m_Faces.size())
+		return m_Faces[vIdx].get();
+	return nullptr;
+}
+
+bool TTFRRW::FontCollection::OpenFaces(const ttfrrwProcessingFlags& vFlags, const char* vDebugInfos, TTFRRW_ATOMIC_PARAMS)
+{
+	TTFRRW_ZONE_API;
+
+	if (vProgress)
+		vProgress->store(0.0f);
+	if (vObjectCount)
+		vObjectCount->store(0U);
+
+	std::vector<const TTFRRW*> openedFaces;
+	size_t facesCount = 1U; // known after the first face
+	for (size_t faceIdx = 0; faceIdx < facesCount; faceIdx++)
+	{
+		ATOMIC_RETURN_IF_STOP_WORKING(false);
+
+		std::unique_ptr<TTFRRW> face(new TTFRRW());
+		face->SetFaceIndex(faceIdx);
+
+		// the faces are opened one after the other, for copy the tables of the previous ones
+		// no progress per face, else each face reset the counters of the collection
+		// the faces borrow the stream of the collection, released after them
+		face->m_SharedFaces = openedFaces;
+		const bool res = face->OpenFontStream(m_Stream.GetDatas(), m_Stream.GetSize(), 
+			vFlags | TTFRRW_PROCESSING_FLAG_BORROW_STREAM, vDebugInfos, vWorking, nullptr, vObjectCount);
+		face->m_SharedFaces.clear();
+
+		if (!faceIdx)
+		{
+			facesCount = face->GetFacesCount();
+			m_Faces.resize(facesCount);
+		}
+
+		if (res)
+		{
+			openedFaces.push_back(face.get());
+			m_Faces[faceIdx] = std::move(face);
+		}
+
+		if (vProgress)
+			vProgress->store((float)(faceIdx + 1U) / (float)facesCount);
+	}
+
+	return !openedFaces.empty();
+}
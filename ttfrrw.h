@@ -3,23 +3,29 @@
 #include <cstdint>
 #include <vector>
 #include <deque>
+#include <list>
 #include <string>
 #include <map>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <stdarg.h> // variadic
+#include <cstdio> // FILE
 #include <utility> // pair
 #include <cmath>
 #include <chrono> // profiler
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
 
 #define USE_SIMPLE_PROFILER
 
 namespace TTFRRW
 {
-	typedef uint16_t CodePoint;
+	typedef uint32_t CodePoint;
 	typedef uint16_t GlyphIndex;
 	typedef uint16_t PaletteIndex;
 
@@ -28,9 +34,12 @@ namespace TTFRRW
 	{
 		TTFRRW_PROCESSING_FLAG_NONE = 0,
 		TTFRRW_PROCESSING_FLAG_NO_GLYPH_PARSING = (1 << 0), // on ne parse pas les points, on prend juste des stats de bases
-		TTFRRW_PROCESSING_FLAG_VERBOSE_ONLY_ERRORS = (1 << 1), // print only the errors to the console
+		TTFRRW_PROCESSING_FLAG_VERBOSE_ONLY_ERRORS = (1 << 1), // print only the errors to the console (the infos are printed only if compiled, see TTFRRW_INFO_LOGS)
 		TTFRRW_PROCESSING_FLAG_VERBOSE_PROFILER = (1 << 2), // print profiler
 		TTFRRW_PROCESSING_FLAG_NO_ERRORS = (1 << 3), // print no erros
+		TTFRRW_PROCESSING_FLAG_LAZY_PARSING = (1 << 4), // only the table directory is read at open, each table is parsed by the first getter who need it
+		TTFRRW_PROCESSING_FLAG_ON_DEMAND_GLYPHS = (1 << 5), // the outlines are decoded at the first GetGlyphOutlineWithXXX and kept in a bounded cache, GetGlyphs and GetGlyphWithXXX give only the metrics
+		TTFRRW_PROCESSING_FLAG_BORROW_STREAM = (1 << 6), // OpenFontStream in lazy or on demand mode : the stream is not copied, the caller keep it alive while the font is used
 	};
 
 	///////////////////////////////////////////////////////////////////////
@@ -52,11 +61,102 @@ namespace TTFRRW
 		double result_Average();
 		double result_Full();
 		size_t result_Count();
+		void merge(const cProfiler& vProfiler); // add the results of another profiler (ex: one per thread)
 		void print(ttfrrwProcessingFlags vFlags, const char* parent, const char* label);
 		void erasePrint(ttfrrwProcessingFlags vFlags, const char* parent, const char* label); // clear console then print
 	};
 #endif
 
+	// named and nested timings, ex : OpenFontFile/Parse_CMAP_Table/format4
+	// each node keep the count, the total, the min, the max and an histogram for the percentiles
+	// thread safe, the nodes are created and filled by TimingScope
+	// copyable for let TTFRRW copyable, the copy have its own mutex
+	class TimingRegistry
+	{
+	public:
+		static const size_t ROOT_NODE = 0U;
+		static const size_t HISTOGRAM_SIZE = 384U; // 8 buckets per power of two of nanoseconds
+
+		struct Stats // times in nanoseconds
+		{
+			uint64_t count = 0U;
+			uint64_t total = 0U;
+			uint64_t min = 0U;
+			uint64_t max = 0U;
+			std::vector<uint32_t> histogram; // allocated at the first add
+
+			void Add(const uint64_t& vNanoSeconds);
+			void Merge(const Stats& vStats);
+			uint64_t GetPercentile(const double& vPercent) const; // vPercent in [0:1], precise at 12% because of the buckets
+		};
+
+		struct Entry // times in seconds
+		{
+			std::string path; // names of the parents and of the node, separated by '/'
+			size_t depth = 0U;
+			uint64_t count = 0U;
+			double total = 0.0;
+			double min = 0.0;
+			double max = 0.0;
+			double p99 = 0.0;
+		};
+
+	private:
+		struct Node
+		{
+			std::string name;
+			size_t parent = ROOT_NODE;
+			std::vector<size_t> children;
+			Stats stats;
+		};
+
+	private:
+		std::vector<Node> m_Nodes; // the root is the first one
+		mutable std::mutex m_Mutex;
+
+	public:
+		TimingRegistry();
+		TimingRegistry(const TimingRegistry& vRegistry);
+		TimingRegistry& operator = (const TimingRegistry& vRegistry);
+
+		size_t GetNode(const size_t& vParentNode, const char* vName); // created at the first call
+		void Add(const size_t& vNode, const uint64_t& vNanoSeconds);
+		void Add(const size_t& vNode, const Stats& vStats); // times accumulated apart, added with one lock
+		void Merge(const TimingRegistry& vRegistry, const size_t& vParentNode); // the nodes of vRegistry are added under vParentNode
+		void Reset();
+
+		std::vector<Entry> GetEntries() const; // depth first, the root is not given
+		bool GetEntry(const std::string& vPath, Entry* vOutEntry) const;
+		std::string GetJson() const; // the tree of the nodes, times in seconds
+		void Print(ttfrrwProcessingFlags vFlags, const char* vLabel) const;
+
+	private:
+		// m_Mutex must be locked
+		size_t GetNodeLocked(const size_t& vParentNode, const std::string& vName);
+		void MergeNode(const std::vector<Node>& vNodes, const size_t& vNode, const size_t& vParentNode);
+		void FillEntries(const size_t& vNode, const std::string& vParentPath, const size_t& vDepth, std::vector<Entry>* vOutEntries) const;
+		void WriteJson(const size_t& vNode, std::string* vOutJson) const;
+	};
+
+	// time of a scope, added to its node at the end of the scope
+	// nothing is measured if the registry is null or if USE_SIMPLE_PROFILER is not defined
+	class TimingScope
+	{
+	private:
+		TimingRegistry* m_Registry = nullptr;
+		TimingRegistry::Stats* m_Stats = nullptr;
+		size_t m_Node = TimingRegistry::ROOT_NODE;
+		std::chrono::steady_clock::time_point m_Start;
+
+	public:
+		TimingScope(TimingRegistry* vRegistry, const size_t& vParentNode, const char* vName);
+		TimingScope(TimingRegistry* vRegistry, const size_t& vNode); // node already known
+		explicit TimingScope(TimingRegistry::Stats* vStats); // for the hot loops, no lock, the stats are owned by the thread
+		~TimingScope();
+		void Stop(); // the time is added now, not at the end of the scope
+		size_t GetNode() const; // parent of the nested scopes
+	};
+
 	///////////////////////////////////////////////////////////////////////
 	///// COMMON///////////////////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////////
@@ -317,6 +417,144 @@ namespace TTFRRW
 	typedef vec4<uint32_t> u32vec4;
 	typedef vec4<uint64_t> u64vec4;
 
+	///////////////////////////////////////////////////////////////////////
+	///// ALLOCATOR ///////////////////////////////////////////////////////
+	///////////////////////////////////////////////////////////////////////
+
+	// memory in use through a counted allocator
+	struct MemoryCounter
+	{
+		std::atomic<int64_t> bytes;
+		std::atomic<int64_t> allocations;
+		std::atomic<uint64_t> totalAllocations; // since the creation of the counter, the freed ones included
+
+		MemoryCounter() : bytes(0), allocations(0), totalAllocations(0U) {}
+	};
+
+	// user allocation callbacks, for route the memory of a font to the allocators of the app
+	// the callbacks are called by many threads at once during the parsing
+	// nullptr callbacks => ::operator new / ::operator delete
+	struct AllocatorHooks
+	{
+		void* (*allocFunc)(size_t vSize, void* vUserDatas) = nullptr;
+		void (*freeFunc)(void* vPtr, size_t vSize, void* vUserDatas) = nullptr;
+		void* userDatas = nullptr;
+		// set by the font for its memory stats, see TTFRRW::GetMemoryStats
+		// shared, because a memory can be freed after its font (ex : outlines shared by the faces of a collection)
+		std::shared_ptr<MemoryCounter> counter;
+
+		bool operator == (const AllocatorHooks& vOther) const
+		{
+			return allocFunc == vOther.allocFunc && freeFunc == vOther.freeFunc && userDatas == vOther.userDatas && 
+				counter == vOther.counter;
+		}
+		bool operator != (const AllocatorHooks& vOther) const { return !(*this == vOther); }
+	};
+
+	// stl allocator calling the hooks, the hooks are shared by the copies,
+	// so a memory is always freed by the hooks who allocated it
+	// the hooks are behind one pointer, since the glyphs have many containers
+	// copy an allocator rather than build a new one from the same hooks, the copy don't allocate
+	template<typename T>
+	class HookAllocator
+	{
+	public:
+		typedef T value_type;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+
+	public:
+		std::shared_ptr<const AllocatorHooks> m_Hooks; // nullptr => ::operator new / ::operator delete, not counted
+
+	public:
+		HookAllocator() {}
+		explicit HookAllocator(const AllocatorHooks& vHooks)
+		{
+			if (vHooks.allocFunc || vHooks.freeFunc || vHooks.counter)
+				m_Hooks = std::make_shared<const AllocatorHooks>(vHooks);
+		}
+		template<typename U> HookAllocator(const HookAllocator<U>& vOther) : m_Hooks(vOther.m_Hooks) {}
+
+		T* allocate(size_t vCount)
+		{
+			const size_t size = vCount * sizeof(T);
+			void* ptr = nullptr;
+			if (m_Hooks && m_Hooks->allocFunc)
+			{
+				ptr = m_Hooks->allocFunc(size, m_Hooks->userDatas);
+				if (!ptr)
+					throw std::bad_alloc();
+			}
+			else
+			{
+				ptr = ::operator new(size);
+			}
+			if (m_Hooks && m_Hooks->counter)
+			{
+				m_Hooks->counter->bytes.fetch_add((int64_t)size, std::memory_order_relaxed);
+				m_Hooks->counter->allocations.fetch_add(1, std::memory_order_relaxed);
+				m_Hooks->counter->totalAllocations.fetch_add(1U, std::memory_order_relaxed);
+			}
+			return (T*)ptr;
+		}
+		void deallocate(T* vPtr, size_t vCount)
+		{
+			if (m_Hooks && m_Hooks->counter)
+			{
+				m_Hooks->counter->bytes.fetch_sub((int64_t)(vCount * sizeof(T)), std::memory_order_relaxed);
+				m_Hooks->counter->allocations.fetch_sub(1, std::memory_order_relaxed);
+			}
+			if (m_Hooks && m_Hooks->freeFunc)
+				m_Hooks->freeFunc(vPtr, vCount * sizeof(T), m_Hooks->userDatas);
+			else
+				::operator delete(vPtr);
+		}
+	};
+
+	template<typename T, typename U>
+	bool operator == (const HookAllocator<T>& vA, const HookAllocator<U>& vB)
+	{
+		if (vA.m_Hooks == vB.m_Hooks)
+			return true;
+		return vA.m_Hooks && vB.m_Hooks && *vA.m_Hooks == *vB.m_Hooks;
+	}
+	template<typename T, typename U>
+	bool operator != (const HookAllocator<T>& vA, const HookAllocator<U>& vB) { return !(vA == vB); }
+
+	typedef std::basic_string<char, std::char_traits<char>, HookAllocator<char>> HookString;
+
+	// memory of a font by subsystem, see TTFRRW::GetMemoryStats
+	// all counted by the allocators of the font
+	enum MemoryCategory
+	{
+		MEMORY_CATEGORY_STREAM = 0, // font file read in memory, a mapped file is not counted
+		MEMORY_CATEGORY_GLYPHS, // array of the glyphs
+		MEMORY_CATEGORY_OUTLINES, // contours and points, the glyph cache included
+		MEMORY_CATEGORY_CMAP, // codepoints <=> glyphs, variation sequences
+		MEMORY_CATEGORY_LOCA, // glyphs offsets
+		MEMORY_CATEGORY_GLYPH_NAMES, // post table and names of the glyphs
+		MEMORY_CATEGORY_LAYERS, // colors, palettes and layers of the glyphs
+		MEMORY_CATEGORY_COMPOSITES, // components of the composite glyphs
+		MEMORY_CATEGORY_NAMES, // name table
+		MEMORY_CATEGORY_PALETTES, // cpal table
+		MEMORY_CATEGORY_TABLES, // table directory, glyph cache bookkeeping
+		MEMORY_CATEGORY_Count
+	};
+
+	struct MemoryStats
+	{
+		struct Category
+		{
+			const char* name = "";
+			size_t bytes = 0U;
+			size_t allocations = 0U;
+			size_t totalAllocations = 0U; // since the creation of the font, the freed ones included
+		};
+		Category categories[MEMORY_CATEGORY_Count];
+		size_t bytes = 0U;
+		size_t allocations = 0U;
+	};
+
 	///////////////////////////////////////////////////////////////////////
 	///// MEMORY STREAM ///////////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////////
@@ -354,12 +592,35 @@ namespace TTFRRW
 		typedef int16_t FWord;
 		typedef int64_t longDateTime;
 		typedef bitfield24 uint24_t;
+		typedef std::vector<uint8_t, HookAllocator<uint8_t>> Datas;
+
+		enum AccessHint // madvise like hints for a range of a mapped stream
+		{
+			ACCESS_HINT_NORMAL = 0,
+			ACCESS_HINT_SEQUENTIAL,
+			ACCESS_HINT_RANDOM,
+			ACCESS_HINT_WILLNEED,
+		};
 
 	public:
 		MemoryStream();
 		MemoryStream(const uint8_t* vDatas, const size_t& vSize);
+		explicit MemoryStream(const AllocatorHooks& vHooks); // the owned datas are allocated by the hooks
+		MemoryStream(const MemoryStream& vMem);
+		MemoryStream(MemoryStream&& vMem);
+		MemoryStream& operator = (const MemoryStream& vMem);
+		MemoryStream& operator = (MemoryStream&& vMem);
 		~MemoryStream();
 
+		// non owning modes, the datas are read in place, without copy
+		// the datas are copied in the owned buffer on the first write
+		bool MapFile(const std::string& vFilePathName, int* vError = nullptr); // read only mapping of a file, vError is set on failure only (errno, or GetLastError on windows)
+		void BorrowDatas(const uint8_t* vDatas, const size_t& vSize); // the caller keep the buffer alive
+		void Advise(const size_t& vOffset, const size_t& vLen, const AccessHint& vHint); // no effect if not mapped
+		bool IsOwner() const;
+		void MakeOwner(); // copy the borrowed or mapped datas in the owned buffer, done before a write
+		void Release();
+
 		void AppendMemoryStream(const MemoryStream& vMem);
 		
 		void WriteByte(const uint8_t& b);
@@ -382,6 +643,7 @@ namespace TTFRRW
 		const uint32_t GetTag(const uint8_t& a, const uint8_t& b, const uint8_t& c, const uint8_t& d);
 		const uint8_t* GetDatas() const;
 		void SetDatas(const uint8_t* vDatas, const size_t& vSize);
+		uint8_t* ResizeDatas(const size_t& vSize); // resize the owned datas, and return them for be filled in place
 		const size_t GetSize() const;
 		const size_t GetPos() const;
 		void SetPos(const size_t& vPos);
@@ -402,36 +664,94 @@ namespace TTFRRW
 		const std::string ReadString(const size_t& vLen, const size_t& vOffset = 0);
 		const std::string ReadTag(const size_t& vOffset = 0);
 
+		// bulk readers of big endian arrays, one bounds check for the whole array
+		// same offset semantic as the single readers, the read pos advance of the array size
+		// the values out of the stream are set to 0, return false in this case
+		bool ReadUShortArray(uint16_t* vDst, const size_t& vCount, const size_t& vOffset = 0);
+		bool ReadShortArray(int16_t* vDst, const size_t& vCount, const size_t& vOffset = 0);
+		bool ReadULongArray(uint32_t* vDst, const size_t& vCount, const size_t& vOffset = 0);
+
 	private:
-		std::vector<uint8_t> m_Datas;
+		Datas m_Datas;
+		const uint8_t* m_ExternalDatas = nullptr; // borrowed or mapped datas, not owned
+		size_t m_ExternalSize = 0;
+		bool m_IsMapped = false;
+		void* m_MapHandle = nullptr; // win32 file mapping handle
 		size_t m_ReadPos = 0;
 	};
 
+	// decoders of the points of a simple glyph : vCount flags, then the x and y coordinates, made absolutes
+	// the stream must be at the flags, after the instructions. they are used by the glyf parser, and tested one against the other
+	// the scalar decoder read byte after byte, the missing bytes of a truncated glyph give 0
+	// the simd decoder work on the raw bytes, it return false if the stream is too short, nothing is consumed in this case
+	void DecodeSimpleGlyfPoints_Scalar(MemoryStream* vMem, const size_t& vCount, uint8_t* vFlags, int16_t* vXCoords, int16_t* vYCoords);
+	bool DecodeSimpleGlyfPoints_Simd(MemoryStream* vMem, const size_t& vCount, uint8_t* vFlags, int16_t* vXCoords, int16_t* vYCoords);
+
 	///////////////////////////////////////////////////////////////////////
 	///// GLYPH ///////////////////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////////
 
+	class Contour;
+
+	// outlines of the glyphs of a font, in structure of arrays
+	// the contours of a glyph follow each other, like the points of a contour
+	class OutlineStore
+	{
+	public:
+		std::vector<int16_t, HookAllocator<int16_t>> m_X;
+		std::vector<int16_t, HookAllocator<int16_t>> m_Y;
+		std::vector<uint8_t, HookAllocator<uint8_t>> m_OnCurve; // 1 if on curve
+		std::vector<uint32_t, HookAllocator<uint32_t>> m_ContourEnds; // end point of each contour (excluded), the start is the end of the previous
+
+	public:
+		OutlineStore() {}
+		explicit OutlineStore(const AllocatorHooks& vHooks);
+		void Clear(); // O(1), the memory is kept for the next font
+		void Resize(const size_t& vPointsCount, const size_t& vContoursCount);
+		size_t GetPointsCount() const { return m_X.size(); }
+		size_t GetContoursCount() const { return m_ContourEnds.size(); }
+		size_t GetMemorySize() const; // bytes reserved
+		Contour GetContour(const size_t& vContourID) const; // contour of the store, not of a glyph
+	};
+
+	// bump allocation in an OutlineStore : place of the next contour and point to write
+	struct OutlineCursor
+	{
+		size_t contour = 0U;
+		size_t point = 0U;
+	};
+
+	// view on a contour of an OutlineStore
 	class Contour
 	{
 	public:
-		std::vector<ivec2> m_Points;
-		std::vector<bool> m_OnCurve;
+		const OutlineStore* m_Store = nullptr;
+		uint32_t m_FirstPoint = 0;
+		uint32_t m_PointsCount = 0;
 
 	public:
-		bool IsValid() { return !m_Points.empty() && !m_OnCurve.empty(); }
-		bool IsOnCurve(size_t vIdx)
+		bool IsValid() const { return m_Store && m_PointsCount; }
+		size_t GetPointsCount() const { return m_PointsCount; }
+		ivec2 GetPoint(size_t vIdx) const
 		{
-			size_t count = m_OnCurve.size();
-			if (count)
-				return m_OnCurve[vIdx % count];
+			if (IsValid())
+			{
+				const size_t idx = m_FirstPoint + vIdx % m_PointsCount;
+				return ivec2((int32_t)m_Store->m_X[idx], (int32_t)m_Store->m_Y[idx]);
+			}
+			return ivec2();
+		}
+		bool IsOnCurve(size_t vIdx) const
+		{
+			if (IsValid())
+				return (m_Store->m_OnCurve[m_FirstPoint + vIdx % m_PointsCount] != 0U);
 			return false;
 		}
-		fvec2 GetCoords(size_t vIdx, fvec2 vScale, fvec2 vTranslation)
+		fvec2 GetCoords(size_t vIdx, fvec2 vScale, fvec2 vTranslation) const
 		{
-			size_t count = m_Points.size();
-			if (count)
+			if (IsValid())
 			{
-				const auto p = m_Points[vIdx % count];
+				const auto p = GetPoint(vIdx);
 				return fvec2((float)p.x, (float)p.y) * vScale + vTranslation;
 			}
 				
@@ -439,6 +759,16 @@ namespace TTFRRW
 		}
 	};
 
+	inline Contour OutlineStore::GetContour(const size_t& vContourID) const
+	{
+		Contour contour;
+		const uint32_t first = vContourID ? m_ContourEnds[vContourID - 1U] : 0U;
+		contour.m_Store = this;
+		contour.m_FirstPoint = first;
+		contour.m_PointsCount = m_ContourEnds[vContourID] - first;
+		return contour;
+	}
+
 	class ComposedGlyph
 	{
 	public:
@@ -447,33 +777,68 @@ namespace TTFRRW
 		GlyphIndex m_GlyphIndex = 0;
 	};
 
+	// allocators of the containers of the glyphs, one by memory category
+	struct GlyphAllocators
+	{
+		HookAllocator<char> names; // MEMORY_CATEGORY_GLYPH_NAMES
+		HookAllocator<char> layers; // MEMORY_CATEGORY_LAYERS
+		HookAllocator<char> composites; // MEMORY_CATEGORY_COMPOSITES
+	};
+
 	class Glyph
 	{
 	public:
-		std::vector<Contour> m_Contours;
+		typedef std::unordered_map<GlyphIndex, fvec4, std::hash<GlyphIndex>, std::equal_to<GlyphIndex>, 
+			HookAllocator<std::pair<const GlyphIndex, fvec4>>> ColorMap;
+		typedef std::unordered_map<GlyphIndex, PaletteIndex, std::hash<GlyphIndex>, std::equal_to<GlyphIndex>, 
+			HookAllocator<std::pair<const GlyphIndex, PaletteIndex>>> PaletteIndexMap;
+		typedef std::vector<GlyphIndex, HookAllocator<GlyphIndex>> GlyphIndexArray;
+		typedef std::set<GlyphIndex, std::less<GlyphIndex>, HookAllocator<GlyphIndex>> GlyphIndexSet;
+		typedef std::vector<ComposedGlyph, HookAllocator<ComposedGlyph>> ComposedGlyphArray;
+
+	public:
+		const OutlineStore* m_Outlines = nullptr; // store of the contours, owned by the font
+		uint32_t m_FirstContour = 0;
+		uint32_t m_ContoursCount = 0;
 		iAABB m_LocalBBox;
 		int32_t m_AdvanceX = 0;
 		int32_t m_LeftSideBearing = 0;
 		int32_t m_RightSideBearing = 0;
-		std::string m_Name;
+		HookString m_Name;
 		bool m_IsSimple = true; // simple or composite
 		CodePoint m_CodePoint = 0;
 
 		// layer // parentGlyphIndex
-		std::unordered_map<GlyphIndex, fvec4> m_Color; // color if is a layer
-		std::unordered_map<GlyphIndex, PaletteIndex> m_PaletteIndex; // palette if is a layer
+		ColorMap m_Color; // color if is a layer
+		PaletteIndexMap m_PaletteIndex; // palette if is a layer
 		bool m_IsLayer = false; // layer
 
-		std::vector<GlyphIndex> m_Layers; // color layers
-		std::set<GlyphIndex> m_Parents; // color layer parents
-		std::vector<ComposedGlyph> m_ComposedGlyph; // for composite
+		GlyphIndexArray m_Layers; // color layers
+		GlyphIndexSet m_Parents; // color layer parents
+		ComposedGlyphArray m_ComposedGlyph; // for composite
 
 	public:
-		bool IsValid()
+		Glyph() {}
+		// the containers are allocated by the allocators of the font, and counted in its memory stats
+		explicit Glyph(const GlyphAllocators& vAllocators)
+			: m_Name(vAllocators.names), m_Color(ColorMap::allocator_type(vAllocators.layers)), 
+			m_PaletteIndex(PaletteIndexMap::allocator_type(vAllocators.layers)), m_Layers(vAllocators.layers), 
+			m_Parents(vAllocators.layers), m_ComposedGlyph(vAllocators.composites) {}
+		// copy in the allocators given, the copy constructor keep the allocators of vGlyph
+		Glyph(const Glyph& vGlyph, const GlyphAllocators& vAllocators) : Glyph(vAllocators) { *this = vGlyph; }
+
+		size_t GetContoursCount() const { return m_Outlines ? m_ContoursCount : 0U; }
+		Contour GetContour(size_t vIdx) const
 		{
-			for (auto& c : m_Contours)
+			if (vIdx < GetContoursCount())
+				return m_Outlines->GetContour(m_FirstContour + vIdx);
+			return Contour();
+		}
+		bool IsValid() const
+		{
+			for (size_t idx = 0; idx < GetContoursCount(); idx++)
 			{
-				bool v = c.IsValid();
+				bool v = GetContour(idx).IsValid();
 				if (v) // au moins un a dessiner on stop la
 					return v;
 			}
@@ -481,6 +846,421 @@ namespace TTFRRW
 		}
 	};
 
+	// a glyph with its outline, the outline is kept alive by the view
+	// so its contours stay valid after an eviction of the glyph cache, or the next open of the font
+	// the view is a copy, it is read without lock while the font decode or evict other glyphs
+	class GlyphOutline
+	{
+	public:
+		const Glyph* m_Glyph = nullptr; // metrics, layers and composites, valid until the next open
+		std::shared_ptr<const OutlineStore> m_Outlines;
+		uint32_t m_FirstContour = 0;
+		uint32_t m_ContoursCount = 0;
+
+	public:
+		size_t GetContoursCount() const { return m_Outlines ? m_ContoursCount : 0U; }
+		Contour GetContour(size_t vIdx) const // valid while the view live
+		{
+			if (vIdx < GetContoursCount())
+				return m_Outlines->GetContour(m_FirstContour + vIdx);
+			return Contour();
+		}
+		bool IsValid() const
+		{
+			for (size_t idx = 0; idx < GetContoursCount(); idx++)
+			{
+				if (GetContour(idx).IsValid())
+					return true;
+			}
+			return false;
+		}
+	};
+
+	///////////////////////////////////////////////////////////////////////
+	///// CMAP ////////////////////////////////////////////////////////////
+	///////////////////////////////////////////////////////////////////////
+
+	static const CodePoint MAX_CODEPOINT = 0x10FFFF;
+
+	// codepoints [start:end] => glyph index
+	struct CodePointRange
+	{
+		CodePoint start = 0;
+		CodePoint end = 0;
+		GlyphIndex glyphIndex = 0;
+	};
+
+	// codepoint => glyph index, in pages of 256 codepoints
+	// the ascii / latin-1 page is direct, the others are allocated only if used
+	// the many to one ranges (cmap format 13) are kept as ranges, and binary searched
+	// a codepoint not mapped give 0, the glyph .notdef
+	class CodePointTable
+	{
+	private:
+		GlyphIndex m_Latin1[256];
+		std::vector<GlyphIndex, HookAllocator<GlyphIndex>> m_Pages; // page 0 is empty, for the not used pages
+		std::vector<uint32_t, HookAllocator<uint32_t>> m_Directory; // codepoint >> 8 => page
+		std::vector<CodePointRange, HookAllocator<CodePointRange>> m_Ranges; // sorted by start
+
+	public:
+		CodePointTable();
+		explicit CodePointTable(const AllocatorHooks& vHooks);
+		void Clear(); // the memory is kept for the next font
+		void Set(const CodePoint& vCodePoint, const GlyphIndex& vGlyphIndex);
+		void AddRange(const CodePoint& vStart, const CodePoint& vEnd, const GlyphIndex& vGlyphIndex);
+		void SortRanges(); // after the last AddRange, if the ranges are not in order
+		GlyphIndex Get(const CodePoint& vCodePoint) const
+		{
+			GlyphIndex res = 0;
+			if (vCodePoint < 256U)
+			{
+				res = m_Latin1[vCodePoint];
+			}
+			else
+			{
+				const size_t page = (size_t)(vCodePoint >> 8);
+				if (page < m_Directory.size())
+					res = m_Pages[((size_t)m_Directory[page] << 8) | (vCodePoint & 0xFFU)];
+			}
+			if (!res && !m_Ranges.empty())
+				res = GetFromRanges(vCodePoint);
+			return res;
+		}
+		size_t GetMemorySize() const; // bytes reserved
+
+		// call vFunc(codePoint, glyphIndex) for each codepoint of the pages, in the order of the codepoints
+		// the ranges are not visited
+		template<typename F>
+		void ForEach(F vFunc) const
+		{
+			for (size_t idx = 0; idx < 256U; idx++)
+			{
+				if (m_Latin1[idx])
+					vFunc((CodePoint)idx, m_Latin1[idx]);
+			}
+			for (size_t page = 1; page < m_Directory.size(); page++)
+			{
+				if (!m_Directory[page])
+					continue;
+				const GlyphIndex* glyphs = &m_Pages[(size_t)m_Directory[page] << 8];
+				for (size_t idx = 0; idx < 256U; idx++)
+				{
+					if (glyphs[idx])
+						vFunc((CodePoint)((page << 8) | idx), glyphs[idx]);
+				}
+			}
+		}
+
+	private:
+		GlyphIndex GetFromRanges(const CodePoint& vCodePoint) const;
+	};
+
+	// view on contiguous codepoints
+	class CodePointSpan
+	{
+	private:
+		const CodePoint* m_Begin = nullptr;
+		const CodePoint* m_End = nullptr;
+
+	public:
+		CodePointSpan() {}
+		CodePointSpan(const CodePoint* vBegin, const CodePoint* vEnd) : m_Begin(vBegin), m_End(vEnd) {}
+		const CodePoint* begin() const { return m_Begin; }
+		const CodePoint* end() const { return m_End; }
+		size_t size() const { return (size_t)(m_End - m_Begin); }
+		bool empty() const { return m_Begin == m_End; }
+		const CodePoint& operator [] (const size_t& vIdx) const { return m_Begin[vIdx]; }
+	};
+
+	// glyph index => codepoints, in compressed sparse rows
+	// the codepoints of a glyph are m_CodePoints[m_Offsets[glyph]:m_Offsets[glyph + 1]], sorted
+	class GlyphCodePointsTable
+	{
+	private:
+		std::vector<uint32_t, HookAllocator<uint32_t>> m_Offsets;
+		std::vector<CodePoint, HookAllocator<CodePoint>> m_CodePoints;
+
+	public:
+		GlyphCodePointsTable() {}
+		explicit GlyphCodePointsTable(const AllocatorHooks& vHooks);
+		void Clear(); // the memory is kept for the next font
+		void Build(const CodePointTable& vCodePoints); // reverse of the pages of the table
+		CodePointSpan Get(const GlyphIndex& vGlyphIndex) const
+		{
+			if ((size_t)vGlyphIndex + 1U < m_Offsets.size())
+				return CodePointSpan(m_CodePoints.data() + m_Offsets[vGlyphIndex], m_CodePoints.data() + m_Offsets[vGlyphIndex + 1U]);
+			return CodePointSpan();
+		}
+		size_t GetMemorySize() const; // bytes reserved
+	};
+
+	// cmap format 14, the glyphs of the variation sequences (codepoint + variation selector)
+	// kept as in the font, the ranges of default codepoints and the list of non default glyphs
+	class VariationSequenceTable
+	{
+	public:
+		enum VariationResult
+		{
+			VARIATION_NOT_FOUND = 0, // the sequence is not in the font
+			VARIATION_DEFAULT, // the sequence use the glyph of the codepoint
+			VARIATION_GLYPH // the sequence use its own glyph
+		};
+
+	private:
+		struct Selector
+		{
+			CodePoint varSelector = 0;
+			uint32_t defaultBegin = 0U, defaultEnd = 0U; // in m_DefaultRanges
+			uint32_t glyphsBegin = 0U, glyphsEnd = 0U; // in m_Glyphs
+		};
+		struct Mapping
+		{
+			CodePoint codePoint = 0;
+			GlyphIndex glyphIndex = 0;
+		};
+
+	private:
+		std::vector<Selector, HookAllocator<Selector>> m_Selectors; // sorted by selector
+		std::vector<CodePointRange, HookAllocator<CodePointRange>> m_DefaultRanges; // sorted by start, for each selector
+		std::vector<Mapping, HookAllocator<Mapping>> m_Glyphs; // sorted by codepoint, for each selector
+
+	public:
+		VariationSequenceTable() {}
+		explicit VariationSequenceTable(const AllocatorHooks& vHooks);
+		void Clear();
+		// a new selector, the next ranges and glyphs are added to it
+		void AddSelector(const CodePoint& vVarSelector);
+		void AddDefaultRange(const CodePoint& vStart, const CodePoint& vEnd);
+		void AddGlyph(const CodePoint& vCodePoint, const GlyphIndex& vGlyphIndex);
+		VariationResult Get(const CodePoint& vCodePoint, const CodePoint& vVarSelector, GlyphIndex* vOutGlyphIndex) const;
+		bool IsEmpty() const { return m_Selectors.empty(); }
+		size_t GetMemorySize() const; // bytes reserved
+	};
+
+	///////////////////////////////////////////////////////////////////////
+	///// THREAD POOL /////////////////////////////////////////////////////
+	///////////////////////////////////////////////////////////////////////
+
+	// work stealing pool : each worker have its own queue of jobs, the threads out of the pool share one more queue
+	// a thread push its jobs in its queue, and take the newest one of its queue first (the nested jobs of the job in progress)
+	// when its queue is empty, it steal the oldest job of the other queues (the other fonts, the other tables)
+	// a job is a range split in chunks, many threads can work on the same job until its chunks are all taken
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void(const size_t& vBegin, const size_t& vEnd)> RangeFunc;
+
+	private:
+		struct Job
+		{
+			RangeFunc func;
+			size_t count = 0;
+			size_t grain = 1;
+			size_t chunks = 0;
+			size_t maxWorkers = 0; // 0 => no limit
+			std::atomic<size_t> nextChunk;
+			std::atomic<size_t> doneChunks;
+			std::atomic<size_t> workers;
+			Job() : nextChunk(0U), doneChunks(0U), workers(0U) {}
+		};
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<std::shared_ptr<Job>> jobs; // pushed and taken by the owner from the back, stolen from the front
+		};
+
+	private:
+		std::vector<std::thread> m_Threads;
+		std::vector<std::unique_ptr<WorkQueue>> m_Queues; // one per worker, the last one for the threads out of the pool
+		std::atomic<size_t> m_QueuedJobs; // in all the queues
+		std::mutex m_Mutex; // for the sleep of the idle threads only
+		std::condition_variable m_JobCondition; // new job, job finished, wake or stop
+		std::atomic<uint64_t> m_Epoch; // changed under m_Mutex at each notify, a thread sleep only if it not changed since its last search
+		bool m_Stop = false;
+
+	public:
+		static ThreadPool* Instance(); // shared pool, one worker per core, the caller is the last one
+
+	public:
+		explicit ThreadPool(const size_t& vThreadCount);
+		~ThreadPool();
+
+		size_t GetThreadCount() const; // workers + caller
+
+		// split [0, vCount) in ranges of vGrain items and call vFunc on each range
+		// the caller thread work too, and return when all the ranges are done
+		// while the workers finish there ranges, the caller steal the pending jobs (other fonts, other ranges)
+		// vMaxThreads limit the count of threads on this job (0 => all, 1 => serial on the caller thread)
+		void ParallelFor(const size_t& vCount, const size_t& vGrain, const RangeFunc& vFunc, const size_t& vMaxThreads = 0U);
+
+		// run vFunc on a worker, return immediatly (run on the caller thread if there is no workers)
+		void Submit(const std::function<void()>& vFunc);
+
+		// the caller run the pending jobs until vDone return true
+		// vDone is checked after each job and after each Wake()
+		void HelpUntil(const std::function<bool()>& vDone);
+		void Wake(); // wake up the threads blocked in HelpUntil
+
+	private:
+		void WorkerLoop(const size_t& vQueueIndex);
+		size_t GetQueueIndex() const; // queue of the calling thread
+		void PushJob(const std::shared_ptr<Job>& vJob, const bool& vWakeAll);
+		std::shared_ptr<Job> PopJob(const size_t& vQueueIndex); // the newest job of its queue, else the oldest job of the other queues
+		std::shared_ptr<Job> TakeJob(WorkQueue* vQueue, const bool& vNewestFirst);
+		void Notify();
+		void RunChunks(Job* vJob);
+	};
+
+	// dependency graph of tasks, run on a ThreadPool
+	// a task start when all its dependencies are done
+	class TaskGraph
+	{
+	public:
+		typedef std::function<void()> TaskFunc;
+
+	private:
+		struct Task
+		{
+			TaskFunc func;
+			std::vector<size_t> successors;
+			size_t dependencyCount = 0;
+			std::atomic<size_t> pendingDependencies;
+			Task() : pendingDependencies(0U) {}
+		};
+
+	private:
+		std::vector<std::unique_ptr<Task>> m_Tasks;
+		std::atomic<size_t> m_RemainingTasks;
+		ThreadPool* m_Pool = nullptr;
+
+	public:
+		TaskGraph();
+
+		// return the id of the task, for the dependencies of the next tasks
+		size_t AddTask(const TaskFunc& vFunc, const std::vector<size_t>& vDependencies = std::vector<size_t>());
+
+		// blocking, return when all the tasks are done
+		// vMaxThreads == 1 => serial run on the caller thread, in the order of the dependencies
+		void Run(ThreadPool* vPool, const size_t& vMaxThreads = 0U);
+
+	private:
+		void Execute(size_t vTaskId);
+	};
+
+	// thread safe once guard, the first caller of Ensure run the function, the others wait its result
+	// copyable for let TTFRRW copyable, the copy have its own mutex
+	class LazyGuard
+	{
+	private:
+		std::atomic<bool> m_Done;
+		bool m_Result = false;
+		std::mutex m_Mutex;
+
+	public:
+		LazyGuard() : m_Done(false) {}
+		LazyGuard(const LazyGuard& vGuard) : m_Done(vGuard.m_Done.load()), m_Result(vGuard.m_Result) {}
+		LazyGuard& operator = (const LazyGuard& vGuard) { m_Result = vGuard.m_Result; m_Done.store(vGuard.m_Done.load()); return *this; }
+
+		template <typename F> bool Ensure(F vFunc)
+		{
+			if (!m_Done.load(std::memory_order_acquire))
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				if (!m_Done.load(std::memory_order_relaxed))
+				{
+					m_Result = vFunc();
+					m_Done.store(true, std::memory_order_release);
+				}
+			}
+			return m_Result;
+		}
+		void Set(const bool& vResult) { m_Result = vResult; m_Done.store(true, std::memory_order_release); }
+		void Reset() { m_Result = false; m_Done.store(false); }
+	};
+
+	///////////////////////////////////////////////////////////////////////
+	///// LOG SINK ////////////////////////////////////////////////////////
+	///////////////////////////////////////////////////////////////////////
+
+	enum LogLevel
+	{
+		LOG_LEVEL_INFOS = 0,
+		LOG_LEVEL_ERROR
+	};
+
+	// asynchronous destination of the logs, instead of the console
+	// the parsers push the messages in a lock free ring buffer, a background thread give them to a callback or a file
+	// when the buffer is full, the messages are dropped and counted, the parsers never wait
+	// the parsers only copy the format pointer and the arguments, the message is formated by the background thread
+	class LogSink
+	{
+	public:
+		typedef std::function<void(const LogLevel& vLevel, const char* vMessage)> LogCallback;
+		static const size_t MESSAGE_SIZE = 240U; // longer messages are truncated
+		static const size_t MAX_ARGS = 8U; // a message with more arguments is formated by the parser
+
+	private:
+		union Arg
+		{
+			long long i; // d i c, extended to long long
+			unsigned long long u; // o u x X, extended to unsigned long long
+			double d;
+			const void* p;
+			size_t text; // s, offset of the copy of the string in texts
+		};
+
+		struct Record
+		{
+			std::atomic<size_t> sequence;
+			LogLevel level = LOG_LEVEL_INFOS;
+			const char* format = nullptr; // null if the message is already formated in texts
+			Arg args[MAX_ARGS];
+			char texts[MESSAGE_SIZE]; // copies of the strings of the %s, since they can be temporaries
+			Record() : sequence(0U) {}
+		};
+
+	private:
+		std::unique_ptr<Record[]> m_Records;
+		size_t m_Mask = 0U;
+		std::atomic<size_t> m_WritePos;
+		size_t m_ReadPos = 0U; // only for the background thread
+		std::atomic<uint64_t> m_DroppedCount;
+		std::atomic<size_t> m_Producers; // pushes in progress
+		std::atomic<bool> m_Running; // the pushes are accepted
+		std::atomic<bool> m_StopRequested;
+		std::thread m_Worker;
+		LogCallback m_Callback;
+		FILE* m_File = nullptr;
+		std::mutex m_StartMutex; // for Start and Stop only
+
+	public:
+		static LogSink* Instance();
+
+	public:
+		LogSink();
+		~LogSink(); // stopped, the pending messages are flushed
+
+		// vCapacity is rounded to a power of two, a running sink is stopped before
+		bool StartWithCallback(const LogCallback& vCallback, const size_t& vCapacity = 1024U);
+		bool StartWithFile(const std::string& vFilePathName, const size_t& vCapacity = 1024U);
+		void Stop(); // the pending messages are flushed
+		bool IsRunning() const;
+		uint64_t GetDroppedCount() const;
+
+		// false if the sink is not running, true if the message is queued or dropped
+		// vFmt is kept until the message is flushed, so it must be a string literal, like in the parsers
+		// %n, * widths, long double and wide strings can't be kept, these messages are formated here
+		bool Push(const LogLevel& vLevel, const char* vFmt, va_list vArgs);
+
+	private:
+		// m_StartMutex must be locked
+		bool StartWorker(const size_t& vCapacity);
+		void StopWorker(); // the pending messages are flushed, the callback and the file are released
+		size_t Flush(); // return the count of messages flushed
+		void WorkerLoop();
+		static void FormatRecord(const Record& vRecord, char* vOutMessage); // vOutMessage of MESSAGE_SIZE
+	};
+
 	///////////////////////////////////////////////////////////////////////
 	///// MAIN CLASS TTFRRW ///////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////////
@@ -489,6 +1269,8 @@ namespace TTFRRW
 	{
 	public:
 		uint32_t m_GlyphCount = 0;
+		uint16_t m_MaxPoints = 0; // maxp : points in a simple glyph
+		uint16_t m_MaxContours = 0; // maxp : contours in a simple glyph
 		iAABB m_GlobalBBox;
 		int16_t m_Ascent = 0;
 		int16_t m_Descent = 0;
@@ -499,27 +1281,34 @@ namespace TTFRRW
 		int16_t m_XMaxExtent = 0;
 	};
 
+	// timings of the last font opened, and of its tables parsed after the open in lazy mode
 	class TTFProfiler
 	{
 	public:
-#ifdef USE_SIMPLE_PROFILER
-		cProfiler simpleGlyfProfiler;
-#endif
+		TimingRegistry timings;
+		size_t stageNode = TimingRegistry::ROOT_NODE; // parent of the tables parsers, the open in progress
+		// times of Parse_Glyph, accumulated without lock by the thread of a glyphs range
+		// given to timings as the node Parse_Glyph by Merge
+		TimingRegistry::Stats glyphs;
+
 	public:
 		void Reset()
 		{
-#ifdef USE_SIMPLE_PROFILER
-			simpleGlyfProfiler.reset();
-#endif
+			timings.Reset();
+			stageNode = TimingRegistry::ROOT_NODE;
+			glyphs = TimingRegistry::Stats();
 		}
 
-		void Print(ttfrrwProcessingFlags vFlags)
+		void Merge(const TTFProfiler& vProfiler, const size_t& vParentNode)
 		{
-#ifdef USE_SIMPLE_PROFILER
-			simpleGlyfProfiler.print(vFlags, "Parse_Simple_Glyf", "");
-#else
-			(void)vFlags;
-#endif
+			timings.Merge(vProfiler.timings, vParentNode);
+			if (vProfiler.glyphs.count)
+				timings.Add(timings.GetNode(vParentNode, "Parse_Glyph"), vProfiler.glyphs);
+		}
+
+		void Print(ttfrrwProcessingFlags vFlags, const char* vLabel) const
+		{
+			timings.Print(vFlags, vLabel);
 		}
 	};
 
@@ -529,22 +1318,44 @@ namespace TTFRRW
 
 	class TTFRRW
 	{
+		friend class FontCollection;
+		friend struct ParserBench; // micro benchmarks of the private parsers, see bench.cpp
+
 	private:
 		TTFInfos m_TTFInfos;
 		TTFProfiler m_TTFProfiler;
 		bool m_IsValid_For_Rasterize = false;
 		bool m_IsValid_For_GlyphTreatment = false;
 		std::string m_FontType;
+		size_t m_ThreadCount = 0U; // threads used for the parsing, 0 => all the threads of the pool
+
+	public:
+		typedef std::vector<Glyph, HookAllocator<Glyph>> GlyphArray;
+
+	private:
+		AllocatorHooks m_AllocatorHooks;
+		std::shared_ptr<MemoryCounter> m_MemoryCounters[MEMORY_CATEGORY_Count];
+		GlyphAllocators m_GlyphAllocators; // the counted hooks of the containers of the glyphs
 
 	private: // must be defined by user
-		std::vector<Glyph> m_Glyphs; // bd des glyphs
-		std::vector<std::string> m_GlyphNames; // bd des noms
+		GlyphArray m_Glyphs; // bd des glyphs
+		std::shared_ptr<OutlineStore> m_Outlines; // contours of the glyphs, arena reused from font to font, can be shared by the faces of a collection
+		// the tables below are read only once parsed, and shared by the faces of a collection
+		typedef std::vector<HookString, HookAllocator<HookString>> GlyphNameArray;
+		std::shared_ptr<const GlyphNameArray> m_GlyphNames; // bd des noms
 		// 1 codePoint => 1 glyphIndex
-		std::map<CodePoint, GlyphIndex> m_CodePoint_To_GlyphIndex;
+		std::shared_ptr<const CodePointTable> m_CodePoint_To_GlyphIndex;
+		// codePoint + variation selector => glyphIndex
+		std::shared_ptr<const VariationSequenceTable> m_VariationSequences;
 		// 1 glyphIndex => can be many codePoint's
-		std::map<GlyphIndex, std::set<CodePoint>> m_GlyphIndex_To_CodePoints;
+		std::shared_ptr<const GlyphCodePointsTable> m_GlyphIndex_To_CodePoints;
+	public:
 		// nameId => names
-		std::set<std::pair<uint16_t, std::string>> m_Names; // bd des noms depuis la table NAME
+		typedef std::pair<uint16_t, HookString> NameEntry;
+		typedef std::set<NameEntry, std::less<NameEntry>, HookAllocator<NameEntry>> NameSet;
+
+	private:
+		NameSet m_Names; // bd des noms depuis la table NAME
 
 	public:
 		TTFRRW();
@@ -554,23 +1365,55 @@ namespace TTFRRW
 			ttfrrwProcessingFlags vFlags = 0, 
 			const char* vDebugInfos = "", 
 			TTFRRW_ATOMIC_PARAMS_DEFAULT);
-		bool OpenFontStream(uint8_t* vStream, 
+		// the stream is read during the open only, except in lazy or on demand mode, where the tables and glyphs are read after it
+		// in these modes the stream is copied, unless TTFRRW_PROCESSING_FLAG_BORROW_STREAM is set, then the caller keep it alive while the font is used
+		bool OpenFontStream(const uint8_t* vStream, 
 			const size_t& vStreamSize,
 			ttfrrwProcessingFlags vFlags = 0, 
 			const char* vDebugInfos = "",
 			TTFRRW_ATOMIC_PARAMS_DEFAULT);
 		void ConsolidateGlyphs(); // finalize the job
 
-		std::vector<Glyph>* GetGlyphs();
-		Glyph* GetGlyphWithGlyphIndex(const GlyphIndex& vGlyphIndex);
+		const NameSet& GetNames();
+		GlyphArray* GetGlyphs();
+		Glyph* GetGlyphWithGlyphIndex(const GlyphIndex& vGlyphIndex); // on demand glyphs : the metrics only, see GetGlyphOutlineWithXXX
 		Glyph* GetGlyphWithCodePoint(const CodePoint& vCodePoint);
+		// the glyph and its contours, decoded in the cache for the on demand glyphs
+		// thread safe, and the outline stay valid while the view live, even if the cache evict it
+		GlyphOutline GetGlyphOutlineWithGlyphIndex(const GlyphIndex& vGlyphIndex);
+		GlyphOutline GetGlyphOutlineWithCodePoint(const CodePoint& vCodePoint);
 		GlyphIndex GetGlyphIndexFromCodePoint(const CodePoint& vCodePoint);
-		std::set<CodePoint>* GetCodePointsFromGlyphIndex(const GlyphIndex& vGlyphIndex);
+		// glyph of a variation sequence, the glyph of the codepoint if the sequence have no specific glyph
+		GlyphIndex GetGlyphIndexFromCodePoint(const CodePoint& vCodePoint, const CodePoint& vVarSelector);
+		CodePointSpan GetCodePointsFromGlyphIndex(const GlyphIndex& vGlyphIndex); // valid until the next open
 		TTFInfos GetFontInfos();
+		TTFProfiler* GetProfiler(); // timings of the last font opened (count, total, min, max, p99 of each parser)
 
 		bool IsValidForRasterize();
 		bool IsValidFotGlyppTreatment();
 
+		void SetThreadCount(const size_t& vThreadCount); // 0 => all the threads of the pool, 1 => no threading
+		size_t GetThreadCount();
+
+		// the memory of the font (stream, glyphs, outlines, cmap) is allocated by the hooks
+		// the font is cleared and its memory released before the change
+		void SetAllocatorHooks(const AllocatorHooks& vHooks);
+		const AllocatorHooks& GetAllocatorHooks() const;
+
+		// bytes and allocations by subsystem, for enforce memory budgets
+		// a memory shared by the faces of a collection is counted by the face who allocated it
+		MemoryStats GetMemoryStats();
+
+		// on demand glyphs : the outlines not in use are evicted over the budget
+		void SetGlyphCacheBudget(const size_t& vBytes); // 0 => no limit
+		size_t GetGlyphCacheBudget();
+		size_t GetGlyphCacheSize(); // bytes used by the outlines in cache
+
+		// collection files (.ttc/.otc), see FontCollection for open all the faces
+		void SetFaceIndex(const size_t& vFaceIndex); // face to open, 0 by default
+		size_t GetFaceIndex();
+		size_t GetFacesCount(); // faces in the file opened, 1 if not a collection
+
 		bool WriteFontFile(const std::string& vFontFilePathName);
 		void AddGlyph(const Glyph& vGlyph, const CodePoint& vCodePoint);
 		
@@ -588,22 +1431,120 @@ namespace TTFRRW
 		};
 
 	private: // read table
-		std::unordered_map<std::string, TableStruct> m_Tables;
+		typedef bool(TTFRRW::* ParseFunc)(MemoryStream*, const ttfrrwProcessingFlags&, TTFRRW_ATOMIC_PARAMS);
+
+		enum LazyTable
+		{
+			LAZY_TABLE_MAXP = 0,
+			LAZY_TABLE_HEAD,
+			LAZY_TABLE_HHEA,
+			LAZY_TABLE_CMAP,
+			LAZY_TABLE_NAME,
+			LAZY_TABLE_POST,
+			LAZY_TABLE_LOCA,
+			LAZY_TABLE_GLYF,
+			LAZY_TABLE_HMTX,
+			LAZY_TABLE_CPAL,
+			LAZY_TABLE_COLR,
+			LAZY_TABLE_Count
+		};
+
+		// lazy mode
+		MemoryStream m_FontStream; // kept open for the tables parsed later
+		ttfrrwProcessingFlags m_LazyFlags = 0;
+		bool m_IsLazy = false;
+		LazyGuard m_LazyTables[LAZY_TABLE_Count];
+
+		// on demand glyphs
+		// the glyphs of m_Glyphs never point on the cache, the outlines are given by GlyphOutline who share them
+		// the copy is empty, with the budget and the allocators of the source, and its own mutex, for let TTFRRW copyable
+		struct GlyphCache
+		{
+			typedef std::list<GlyphIndex, HookAllocator<GlyphIndex>> LRU;
+			struct Entry
+			{
+				LRU::iterator lru;
+				std::shared_ptr<const OutlineStore> outlines; // contours of the glyph only, null if no contours
+				uint32_t firstContour = 0;
+				uint32_t contoursCount = 0;
+				size_t bytes = 0U;
+			};
+			typedef std::unordered_map<GlyphIndex, Entry, std::hash<GlyphIndex>, std::equal_to<GlyphIndex>, 
+				HookAllocator<std::pair<const GlyphIndex, Entry>>> Entries;
+
+			size_t budget = 0U; // bytes, 0 => no limit
+			size_t size = 0U; // bytes
+			LRU lru; // most recently used first
+			Entries entries;
+			mutable std::mutex mutex; // for all the members
+
+			GlyphCache() {}
+			explicit GlyphCache(const HookAllocator<char>& vAllocator) : lru(LRU::allocator_type(vAllocator)), entries(Entries::allocator_type(vAllocator)) {}
+			GlyphCache(const GlyphCache& vCache) : GlyphCache(HookAllocator<char>(vCache.lru.get_allocator())) { budget = vCache.GetBudget(); }
+			GlyphCache& operator = (const GlyphCache& vCache)
+			{
+				if (this != &vCache)
+				{
+					const size_t sourceBudget = vCache.GetBudget();
+					const HookAllocator<char> allocator(vCache.lru.get_allocator());
+					std::unique_lock<std::mutex> lock(mutex);
+					budget = sourceBudget;
+					size = 0U;
+					lru = LRU(LRU::allocator_type(allocator));
+					entries = Entries(Entries::allocator_type(allocator));
+				}
+				return *this;
+			}
+			size_t GetBudget() const
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				return budget;
+			}
+		};
+		ttfrrwProcessingFlags m_GlyphsFlags = 0;
+		bool m_IsGlyphsOnDemand = false;
+		GlyphCache m_GlyphCache;
+
+		// collection
+		size_t m_FaceIndex = 0U;
+		size_t m_FacesCount = 0U;
+		std::vector<const TTFRRW*> m_SharedFaces; // previous faces of the collection, only during the open
+
+
+		// the tags stay in the small buffer of the strings, so only the nodes and the buckets are allocated
+		typedef std::unordered_map<std::string, TableStruct, std::hash<std::string>, std::equal_to<std::string>, 
+			HookAllocator<std::pair<const std::string, TableStruct>>> TableMap;
+		TableMap m_Tables;
 		uint16_t m_IndexToLocFormat = 0; // head table : loca format
-		std::vector<size_t> m_GlyphsOffsets; // loca table : glyphs address
-		std::vector<std::vector<fvec4>> m_Palettes; // palette > colors > color
+		typedef std::vector<size_t, HookAllocator<size_t>> GlyphsOffsets;
+		std::shared_ptr<const GlyphsOffsets> m_GlyphsOffsets; // loca table : glyphs address, shared by the faces of a collection
+		typedef std::vector<fvec4, HookAllocator<fvec4>> PaletteColors;
+		std::vector<PaletteColors, HookAllocator<PaletteColors>> m_Palettes; // palette > colors > color
 		int16_t m_MumOfLongHorMetrics = 0; // fromm hhea for hmtx
 
 		void Clear(TTFRRW_ATOMIC_PARAMS);
-		bool LoadFileToMemory(const std::string& vFilePathName, MemoryStream* vOutMem, int* vError);
+		AllocatorHooks GetCountedHooks(const MemoryCategory& vCategory) const; // the user hooks, with the counter of the category
+		void ResetContainers(); // rebuilt with the counted hooks, the memory is released
+		void ResetSharedTables(); // new empty cmap, loca and post tables, the shared ones are left to the other faces
+		void PlotFontState() const; // tracy plots of the glyphs count and of the counted memory, nothing without tracy
+		static bool LoadFileToMemory(const std::string& vFilePathName, MemoryStream* vOutMem, int* vError);
 		bool Parse_Font_File(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
+		bool EnsureTable(const LazyTable& vTable); // parse the table and its dependencies if not done, lazy mode only
+		bool EnsureGlyphs(); // parse all the glyphs related tables, lazy mode only
+		GlyphOutline EnsureGlyphOutline(const GlyphIndex& vGlyphIndex); // decode the outline if not in cache, on demand glyphs only
+		void TrimGlyphCache(); // evict the least recently used outlines over the budget, the ones in use stay alive in their views
 		bool Parse_Table_Header(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
+		bool HasSameTables(const TTFRRW* vFace, const std::vector<std::string>& vTags) const; // same offset and length, or absent in both
+		const TTFRRW* GetSharedFace(const std::vector<std::string>& vTags) const; // a previous face with the same tables, nullptr if none
 		bool Parse_CMAP_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
+		void Parse_CMAP_Variations(MemoryStream* vInMem, const size_t& vSubtableOffset, VariationSequenceTable* vOutVariations, const ttfrrwProcessingFlags& vFlags);
 		bool Parse_HEAD_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
 		bool Parse_LOCA_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
 		bool Parse_MAXP_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
 		bool Parse_GLYF_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
-		Glyph Parse_Simple_Glyf(MemoryStream* vInMem, const GlyphIndex& vGlyphIndex, const int16_t& vCountContour, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
+		Glyph Parse_Glyph(MemoryStream* vMem, const size_t& vGlyfOffset, const GlyphIndex& vGlyphIndex, OutlineStore* vOutlines, OutlineCursor* vCursor, TTFProfiler* vProfiler, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
+		bool Parse_Simple_Glyf(MemoryStream* vInMem, const GlyphIndex& vGlyphIndex, const int16_t& vCountContour, OutlineStore* vOutlines, OutlineCursor* vCursor, Glyph* vOutGlyph, TTFProfiler* vProfiler, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
+		OutlineCursor Count_Glyph_Outline(MemoryStream* vMem, const size_t& vGlyfOffset, const GlyphIndex& vGlyphIndex); // contours and points of a simple glyph, without decode it
 		bool Parse_POST_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
 		bool Parse_CPAL_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
 		bool Parse_COLR_Table(MemoryStream* vInMem, const ttfrrwProcessingFlags& vFlags, TTFRRW_ATOMIC_PARAMS);
@@ -628,4 +1569,73 @@ namespace TTFRRW
 		MemoryStream Assemble_NAME_Table();
 		MemoryStream Assemble_HEAD_Table();
 	};
+
+	///////////////////////////////////////////////////////////////////////
+	///// FONT BATCH //////////////////////////////////////////////////////
+	///////////////////////////////////////////////////////////////////////
+
+	// open many fonts at once on the shared ThreadPool
+	// each idle thread take the next font, and steal glyph ranges of the fonts in progress
+	class FontBatch
+	{
+	private:
+		struct Source
+		{
+			std::string path;
+			const uint8_t* stream = nullptr; // borrowed, if not from a file
+			size_t streamSize = 0U;
+		};
+
+	private:
+		std::vector<Source> m_Sources;
+		std::vector<std::unique_ptr<TTFRRW>> m_Fonts; // nullptr if not opened
+		size_t m_ThreadCount = 0U;
+
+	public:
+		void AddFontFile(const std::string& vFontFilePathName);
+		void AddFontStream(const uint8_t* vStream, const size_t& vStreamSize); // the stream must stay alive while the font is used
+		void Clear();
+
+		void SetThreadCount(const size_t& vThreadCount); // 0 => all the threads of the pool, 1 => no threading
+
+		// open all the fonts added, return the count of fonts opened
+		// vProgress is the ratio of fonts done, vObjectCount the sum of the objects of all the fonts
+		// vWorking stop the fonts in progress and skip the others
+		size_t Open(ttfrrwProcessingFlags vFlags = 0, TTFRRW_ATOMIC_PARAMS_DEFAULT);
+
+		size_t GetFontsCount() const;
+		TTFRRW* GetFont(const size_t& vIdx); // nullptr if not opened
+	};
+
+	///////////////////////////////////////////////////////////////////////
+	///// FONT COLLECTION /////////////////////////////////////////////////
+	///////////////////////////////////////////////////////////////////////
+
+	// all the faces of a collection file (.ttc/.otc)
+	// the tables at the same offset in many faces are parsed once, and shared with the next faces :
+	// the cmap, loca and post tables and the outlines are shared, the glyphs are copied since each face have its own metrics and colors
+	class FontCollection
+	{
+	private:
+		MemoryStream m_Stream; // the faces read in it
+		std::vector<std::unique_ptr<TTFRRW>> m_Faces; // nullptr if not opened
+
+	public:
+		bool OpenCollectionFile(const std::string& vFontFilePathName,
+			ttfrrwProcessingFlags vFlags = 0,
+			const char* vDebugInfos = "",
+			TTFRRW_ATOMIC_PARAMS_DEFAULT);
+		bool OpenCollectionStream(const uint8_t* vStream, // the stream must stay alive while the faces are used
+			const size_t& vStreamSize,
+			ttfrrwProcessingFlags vFlags = 0,
+			const char* vDebugInfos = "",
+			TTFRRW_ATOMIC_PARAMS_DEFAULT);
+		void Clear();
+
+		size_t GetFacesCount() const;
+		TTFRRW* GetFace(const size_t& vIdx); // nullptr if not opened
+
+	private:
+		bool OpenFaces(const ttfrrwProcessingFlags& vFlags, const char* vDebugInfos, TTFRRW_ATOMIC_PARAMS);
+	};
 }
\ No newline at end of file